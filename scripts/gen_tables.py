@@ -1,3 +1,4 @@
+import functools
 import sys
 import re
 
@@ -43,7 +44,7 @@ def findBestBlockSize(values):
     return blockSize
 
 def isPremitiveType(type):
-    return type == 'int' or type == 'uint32_t' or type == 'uint64_t' or type == 'NormalizationProperties'
+    return type == 'int' or type == 'uint8_t' or type == 'uint16_t' or type == 'uint32_t' or type == 'uint64_t' or type == 'NormalizationProperties'
 
 def generateTable(name, type, defval, out, values):
     def formatValue(val):
@@ -58,11 +59,11 @@ def generateTable(name, type, defval, out, values):
     else:
         out.write("""namespace {0} {{
 using T = {1};
-const auto D = {1}::{2};
+constexpr auto D = {1}::{2};
 """.format(name, type, defval))
 
     blockSize = findBestBlockSize(values)
-    out.write("static const size_t _block_size = {};\n".format(blockSize))
+    out.write("inline constexpr size_t _block_size = {};\n".format(blockSize))
 
     blockValues = []
     for i in range(0, len(values), blockSize):
@@ -72,12 +73,12 @@ const auto D = {1}::{2};
         else:
             blockValues.append(None)
             iblock = i // blockSize
-            out.write("static const {} _{}[] = {{ ".format(type, iblock))
+            out.write("inline constexpr {} _{}[] = {{ ".format(type, iblock))
             for val in items:
                 out.write(formatValue(val))
             out.write(" };\n")
 
-    out.write("static const {} *_blocks[] = {{\n".format(type))
+    out.write("inline constexpr const {} *_blocks[] = {{\n".format(type))
     for iblock, blockValue in enumerate(blockValues):
         if iblock % 8 == 0:
             if iblock == 0:
@@ -90,7 +91,7 @@ const auto D = {1}::{2};
             out.write("_{},".format(iblock))
     out.write("\n};\n")
 
-    out.write("static const {} _block_values[] = {{\n".format(type))
+    out.write("inline constexpr {} _block_values[] = {{\n".format(type))
     for iblock, blockValue in enumerate(blockValues):
         if iblock % 8 == 0:
             if iblock == 0:
@@ -122,7 +123,8 @@ const auto D = {1}::{2};
 # genGeneralCategoryPropertyTable
 #------------------------------------------------------------------------------
 
-def genGeneralCategoryPropertyTable(ucd):
+@functools.lru_cache(maxsize=None)
+def generalCategoryValues(ucd):
     fin = open(ucd + '/UnicodeData.txt')
 
     defval = 'Cn'
@@ -155,8 +157,11 @@ def genGeneralCategoryPropertyTable(ucd):
         for cp in range(codePointPrev + 1, MaxCopePoint + 1):
             yield cp, defval
 
-    values = [val for cp, val in items()]
-    generateTable('_general_category_properties', 'GeneralCategory', defval, sys.stdout, values)
+    return [val for cp, val in items()]
+
+def genGeneralCategoryPropertyTable(ucd):
+    values = generalCategoryValues(ucd)
+    generateTable('_general_category_properties', 'GeneralCategory', 'Cn', sys.stdout, values)
 
 #------------------------------------------------------------------------------
 # genPropertyTable
@@ -201,7 +206,8 @@ PROPERTY_BITS = {
     'Prepended_Concatenation_Mark': 32,
 }
 
-def genPropertyTable(ucd):
+@functools.lru_cache(maxsize=None)
+def propertyValues(ucd):
     fin = open(ucd + '/PropList.txt')
 
     values = [0] * (MaxCopePoint + 1)
@@ -229,6 +235,10 @@ def genPropertyTable(ucd):
         print('NOTE: PropList property not exposed by unicodelib: ' + name,
               file=sys.stderr)
 
+    return values
+
+def genPropertyTable(ucd):
+    values = propertyValues(ucd)
     generateTable('_properties', "uint64_t", 0, sys.stdout, values)
 
 #------------------------------------------------------------------------------
@@ -262,7 +272,8 @@ DERIVED_PROPERTY_BITS = {
     'InCB_Extend': 21,
 }
 
-def genDerivedCorePropertyTable(ucd):
+@functools.lru_cache(maxsize=None)
+def derivedCorePropertyValues(ucd):
     fin = open(ucd + '/DerivedCoreProperties.txt')
 
     values = [0] * (MaxCopePoint + 1)
@@ -296,6 +307,10 @@ def genDerivedCorePropertyTable(ucd):
         print('NOTE: DerivedCoreProperties property not exposed by '
               'unicodelib: ' + name, file=sys.stderr)
 
+    return values
+
+def genDerivedCorePropertyTable(ucd):
+    values = derivedCorePropertyValues(ucd)
     generateTable('_derived_core_properties', "uint32_t", 0, sys.stdout, values)
 
 #------------------------------------------------------------------------------
@@ -335,10 +350,20 @@ def genSimpleCaseMappingTable(ucd):
                 codePointPrev = codePoint
                 i += 1
 
-    print("inline const std::unordered_map<char32_t, const char32_t*> _simple_case_mappings = {")
+    # Each code point maps to a shared (upper, lower, title) delta record.
+    # Record 0 is the identity mapping.
+    deltas = {(0, 0, 0): 0}
+    values = [0] * (MaxCopePoint + 1)
     for cp, upper, lower, title in items():
-        print('{ 0x%08X, U"\\U%08X\\U%08X\\U%08X" },' % (cp, upper, lower, title))
+        values[cp] = deltas.setdefault((upper - cp, lower - cp, title - cp), len(deltas))
+    if len(deltas) > 0xFF:
+        sys.exit('error: too many distinct simple case mapping deltas')
+
+    print("inline constexpr int32_t _simple_case_mapping_deltas[][3] = {")
+    for delta in deltas:
+        print('{ %d, %d, %d },' % delta)
     print("};")
+    generateTable('_simple_case_mapping_indexes', 'uint8_t', 0, sys.stdout, values)
 
 #------------------------------------------------------------------------------
 # genSpecialCaseMappingTable
@@ -380,20 +405,24 @@ def genSpecialCaseMappingTable(ucd):
 
                 yield cp, lower, title, upper, language, context, hasContext
 
+    # Both tables are sorted by code point for binary search. The sort is
+    # stable, so entries for the same code point keep their file order.
+    entries = sorted(items(), key=lambda x: x[0])
+
     # Regular
-    print("inline const std::unordered_multimap<char32_t, SpecialCasing> _special_case_mappings = {")
-    for cp, lower, title, upper, language, context, hasContext in items():
+    print("inline constexpr SpecialCasing _special_case_mappings[] = {")
+    for cp, lower, title, upper, language, context, hasContext in entries:
         if hasContext == True:
-            print('{ 0x%08X, { %s, %s, %s, %s, SpecialCasingContext::%s } },'
+            print('{ 0x%08X, %s, %s, %s, %s, SpecialCasingContext::%s },'
                     % (cp, to_unicode_literal(lower), to_unicode_literal(title),
                         to_unicode_literal(upper), language, context))
     print("};")
 
     # Default
-    print("inline const std::unordered_multimap<char32_t, SpecialCasing> _special_case_mappings_default = {")
-    for cp, lower, title, upper, language, context, hasContext in items():
+    print("inline constexpr SpecialCasing _special_case_mappings_default[] = {")
+    for cp, lower, title, upper, language, context, hasContext in entries:
         if hasContext == False:
-            print('{ 0x%08X, { %s, %s, %s, %s, SpecialCasingContext::%s } },'
+            print('{ 0x%08X, %s, %s, %s, %s, SpecialCasingContext::%s },'
                     % (cp, to_unicode_literal(lower), to_unicode_literal(title),
                         to_unicode_literal(upper), language, context))
     print("};")
@@ -426,18 +455,44 @@ def genCaseFoldingTable(ucd):
             elif status == 'T':
                 dic[cp][3] = codes[0]
 
-    print("inline const std::unordered_map<char32_t, CaseFolding> _case_foldings = {")
+    # Full (F) mappings are stored back to back as null-terminated sequences.
+    # Offset 0 is an empty sequence, which stands for "no full mapping".
+    pool = [0]
+    offsets = {(): 0}
     for cp in dic:
-        cf = dic[cp]
-        f = to_unicode_literal(cf[2])
-        print('{ 0x%08X, { 0x%08X,  0x%08X, %s, 0x%08X } },' % (cp, cf[0], cf[1], f, cf[3]))
+        f = tuple(dic[cp][2])
+        if f not in offsets:
+            offsets[f] = len(pool)
+            pool.extend(f + (0,))
+    if len(pool) > 0xFFFF:
+        sys.exit('error: case folding sequence pool is too large')
+
+    records = {(0, 0, 0): 0}
+    values = [0] * (MaxCopePoint + 1)
+    for cp in dic:
+        c, s, f, t = dic[cp]
+        simple = s or c
+        rec = (simple - cp if simple else 0, t - cp if t else 0, offsets[tuple(f)])
+        values[cp] = records.setdefault(rec, len(records))
+    if len(records) > 0xFF:
+        sys.exit('error: too many distinct case folding records')
+
+    print("inline constexpr char32_t _case_folding_full_codes[] = {")
+    for i in range(0, len(pool), 8):
+        print(' ' + ''.join('0x%08X,' % x for x in pool[i:i+8]))
+    print("};")
+    print("inline constexpr CaseFolding _case_folding_records[] = {")
+    for rec in records:
+        print('{ %d, %d, %d },' % rec)
     print("};")
+    generateTable('_case_folding_indexes', 'uint8_t', 0, sys.stdout, values)
 
 #------------------------------------------------------------------------------
 # genBlockPropertyTable
 #------------------------------------------------------------------------------
 
-def genBlockPropertyTable(ucd):
+@functools.lru_cache(maxsize=None)
+def blockValues(ucd):
     fin = open(ucd + '/Blocks.txt')
 
     defval = 'Unassigned'
@@ -454,13 +509,18 @@ def genBlockPropertyTable(ucd):
             for cp in range(codePointFirst, codePointLast + 1):
                 values[cp] = block
 
-    generateTable('_block_properties', 'Block', defval, sys.stdout, values)
+    return values
+
+def genBlockPropertyTable(ucd):
+    values = blockValues(ucd)
+    generateTable('_block_properties', 'Block', 'Unassigned', sys.stdout, values)
 
 #------------------------------------------------------------------------------
 # genScriptPropertyTable
 #------------------------------------------------------------------------------
 
-def genScriptPropertyTable(ucd):
+@functools.lru_cache(maxsize=None)
+def scriptValues(ucd):
     fin = open(ucd + '/Scripts.txt')
 
     defval = 'Unassigned'
@@ -480,7 +540,11 @@ def genScriptPropertyTable(ucd):
             else:
                 values[codePoint] = value
 
-    generateTable('_script_properties', 'Script', defval, sys.stdout, values)
+    return values
+
+def genScriptPropertyTable(ucd):
+    values = scriptValues(ucd)
+    generateTable('_script_properties', 'Script', 'Unassigned', sys.stdout, values)
 
 #------------------------------------------------------------------------------
 # genScriptExtensionTable
@@ -665,12 +729,17 @@ def genScriptExtensionTable(ucd):
 
     fin = open(ucd + '/ScriptExtensions.txt')
 
-    values = [-1] * (MaxCopePoint + 1)
+    values = [0] * (MaxCopePoint + 1)
     r = re.compile(r"([0-9A-F]+)(?:\.\.([0-9A-F]+))?\s*;\s*(.*?)\s*#.*")
 
+    # Script lists are stored back to back, each ending with
+    # Script::Unassigned. Offset 0 is an empty list for code points without
+    # Script_Extensions.
     ids = {}
+    offset = 1
 
-    print("inline const std::vector<std::vector<Script>> _script_extension_properties_for_id = {")
+    print("inline constexpr Script _script_extension_properties[] = {")
+    print("    Script::Unassigned,")
     for line in fin:
         m = r.match(line)
         if m:
@@ -686,24 +755,29 @@ def genScriptExtensionTable(ucd):
             if scripts in ids:
                 id = ids[scripts]
             else:
-                id = len(ids)
+                id = offset
                 ids[scripts] = id
-                print('{')
                 for sc in [dic[x] for x in scripts.split(' ')]:
-                    print('    Script::%s, ' % sc)
-                print('},')
+                    print('    Script::%s,' % sc)
+                    offset += 1
+                print('    Script::Unassigned,')
+                offset += 1
 
             for cp in range(firstCode, lastCode):
                 values[cp] = id
     print("};")
 
-    generateTable('_script_extension_ids', "int", 0, sys.stdout, values)
+    if offset > 0xFFFF:
+        sys.exit('error: too many script extensions')
+
+    generateTable('_script_extension_ids', "uint16_t", 0, sys.stdout, values)
 
 #------------------------------------------------------------------------------
 # genNomalizationPropertyTable
 #------------------------------------------------------------------------------
 
-def genNomalizationPropertyTable(ucd):
+@functools.lru_cache(maxsize=None)
+def normalizationPropertyValues(ucd):
     fin = open(ucd + '/UnicodeData.txt')
 
     data = [x.rstrip().split(';') for x in fin]
@@ -718,8 +792,9 @@ def genNomalizationPropertyTable(ucd):
             combiningClass = int(flds[3])
             codes = flds[5]
 
+            # Unassigned code points have combining class 0.
             for cp in range(codePointPrev + 1, codePoint):
-                yield cp, combiningClass, None, []
+                yield cp, 0, None, []
 
             if flds[1].endswith('First>'):
                 fldsLast = data[i + 1]
@@ -740,27 +815,99 @@ def genNomalizationPropertyTable(ucd):
                 i += 1
 
         for cp in range(codePointPrev + 1, MaxCopePoint + 1):
-            yield cp, combiningClass, None, []
+            yield cp, 0, None, []
 
+    return [(cls, compat, codes) for cp, cls, compat, codes in items()]
+
+def genNomalizationPropertyTable(ucd):
+    props = normalizationPropertyValues(ucd)
+
+    # Decompositions are expanded recursively here, so that decomposing a
+    # character at run time is a single append from one of two pools.
+    # (Hangul syllables are decomposed algorithmically and never appear in
+    # UnicodeData.txt decomposition mappings.)
+    def decompose(cp, compat):
+        cls, fmt, codes = props[cp]
+        if codes and (compat or not fmt):
+            return [x for c in codes for x in decompose(c, compat)]
+        return [cp]
+
+    def pooled(pool, offsets, codes):
+        key = tuple(codes)
+        if key not in offsets:
+            offsets[key] = len(pool)
+            pool.extend(codes)
+        return offsets[key]
+
+    # DerivedNormalizationProps.txt is not part of the UCD subset used here,
+    # so the quick check values are derived as described in UAX #15:
+    # - NF(K)D_QC is No for anything with a canonical (compatibility)
+    #   decomposition, including Hangul syllables.
+    # - NFC_QC is No for characters that decompose but are not primary
+    #   composites, and Maybe for characters that can be the second half of a
+    #   composition (including Hangul medial vowels and trailing consonants)
+    #   or whose decomposition starts with such a character (e.g. U+16123).
+    # - NFKC_QC is No where NFC_QC is No or a compatibility mapping applies.
+    compositions = canonicalCompositions(ucd)
+    composites = set(cp for first, second, cp in compositions)
+    seconds = set(second for first, second, cp in compositions)
+    seconds.update(range(0x1161, 0x1176))  # Hangul V
+    seconds.update(range(0x11A8, 0x11C3))  # Hangul T
+    Yes, No, Maybe = 0, 1, 2
+
+    def isHangulSyllable(cp):
+        return 0xAC00 <= cp < 0xAC00 + 11172
+
+    canonical, canonicalOffsets = [], {}
+    compatibility, compatibilityOffsets = [], {}
     values = []
-    for cp, cls, compat, codes in items():
-        if compat:
-            compat = '"%s"' % compat
-        else:
-            compat = '0'
+    for cp, (cls, fmt, codes) in enumerate(props):
+        rec = [cls, 0, 0, 0, 0, 0]
+        nfd = nfkd = [cp]
         if codes:
-            codes = 'U"%s"' % ''.join(["\\U%08X" % x for x in codes])
+            for compat, pool, offsets, i in ((False, canonical, canonicalOffsets, 1),
+                                             (True, compatibility, compatibilityOffsets, 2)):
+                full = decompose(cp, compat)
+                if full != [cp]:
+                    rec[i] = len(full)
+                    rec[i + 3] = pooled(pool, offsets, full)
+                if compat:
+                    nfkd = full
+                else:
+                    nfd = full
+
+        nfdQC = No if nfd != [cp] or isHangulSyllable(cp) else Yes
+        nfkdQC = No if nfkd != [cp] or isHangulSyllable(cp) else Yes
+        if nfd != [cp] and cp not in composites:
+            nfcQC = No
+        elif cp in seconds or nfd[0] in seconds:
+            nfcQC = Maybe
         else:
-            codes = '0'
-        values.append("{{{},{},{}}}".format(cls, compat, codes))
+            nfcQC = Yes
+        nfkcQC = No if nfcQC == No or nfkd != nfd else nfcQC
+
+        # Two bits per form, in the order of enum class Normalization.
+        rec[3] = nfcQC | (nfdQC << 2) | (nfkcQC << 4) | (nfkdQC << 6)
+        values.append("{{{},{},{},{},{},{}}}".format(*rec))
 
-    generateTable('_normalization_properties', 'NormalizationProperties', "{0,0,0}", sys.stdout, values)
+    if max(len(canonical), len(compatibility)) > 0xFFFF:
+        sys.exit('error: decomposition pools are too large')
+
+    for name, pool in (('_canonical_decompositions', canonical),
+                       ('_compatibility_decompositions', compatibility)):
+        print("inline constexpr char32_t %s[] = {" % name)
+        for i in range(0, len(pool), 8):
+            print(' ' + ''.join('0x%08X,' % x for x in pool[i:i+8]))
+        print("};")
+
+    generateTable('_normalization_properties', 'NormalizationProperties', "{0,0,0,0,0,0}", sys.stdout, values)
 
 #------------------------------------------------------------------------------
 # genNomalizationCompositionTable
 #------------------------------------------------------------------------------
 
-def genNomalizationCompositionTable(ucd):
+@functools.lru_cache(maxsize=None)
+def canonicalCompositions(ucd):
     fin = open(ucd + '/UnicodeData.txt')
     finExclusions = open(ucd + '/CompositionExclusions.txt')
 
@@ -804,17 +951,37 @@ def genNomalizationCompositionTable(ucd):
             else:
                 exclusions.add(first)
 
-    print("inline const std::unordered_map<std::u32string, char32_t> _normalization_composition = {")
-    for cp, codes in items():
-        if not cp in exclusions:
-            print('{ U"\\U%08X\\U%08X", 0x%08X },' % (codes[0], codes[1], cp))
+    return [(codes[0], codes[1], cp) for cp, codes in items() if not cp in exclusions]
+
+def genNomalizationCompositionTable(ucd):
+    starters = {}
+    for first, second, cp in canonicalCompositions(ucd):
+        starters.setdefault(first, []).append((second, cp))
+
+    # Pairs are grouped by their first code point, and each group ends with
+    # {0, 0}. Offset 0 is an empty group for code points that start nothing.
+    values = [0] * (MaxCopePoint + 1)
+    print("inline constexpr Composition _normalization_compositions[] = {")
+    print("{ 0, 0 },")
+    offset = 1
+    for starter in sorted(starters):
+        values[starter] = offset
+        for second, cp in sorted(starters[starter]):
+            print('{ 0x%08X, 0x%08X },' % (second, cp))
+        print("{ 0, 0 },")
+        offset += len(starters[starter]) + 1
     print("};")
+    if offset > 0xFFFF:
+        sys.exit('error: too many canonical compositions')
+
+    generateTable('_normalization_composition_indexes', 'uint16_t', 0, sys.stdout, values)
 
 #------------------------------------------------------------------------------
 # genGraphemeBreakPropertyTable
 #------------------------------------------------------------------------------
 
-def genGraphemeBreakPropertyTable(ucd):
+@functools.lru_cache(maxsize=None)
+def graphemeBreakValues(ucd):
     fin = open(ucd + '/auxiliary/GraphemeBreakProperty.txt')
 
     defval = 'Unassigned'
@@ -834,13 +1001,18 @@ def genGraphemeBreakPropertyTable(ucd):
             else:
                 values[codePoint] = value
 
-    generateTable('_grapheme_break_properties', 'GraphemeBreak', defval, sys.stdout, values)
+    return values
+
+def genGraphemeBreakPropertyTable(ucd):
+    values = graphemeBreakValues(ucd)
+    generateTable('_grapheme_break_properties', 'GraphemeBreak', 'Unassigned', sys.stdout, values)
 
 #------------------------------------------------------------------------------
 # genWordBreakPropertyTable
 #------------------------------------------------------------------------------
 
-def genWordBreakPropertyTable(ucd):
+@functools.lru_cache(maxsize=None)
+def wordBreakValues(ucd):
     fin = open(ucd + '/auxiliary/WordBreakProperty.txt')
 
     defval = 'Unassigned'
@@ -860,13 +1032,18 @@ def genWordBreakPropertyTable(ucd):
             else:
                 values[codePoint] = value
 
-    generateTable('_word_break_properties', 'WordBreak', defval, sys.stdout, values)
+    return values
+
+def genWordBreakPropertyTable(ucd):
+    values = wordBreakValues(ucd)
+    generateTable('_word_break_properties', 'WordBreak', 'Unassigned', sys.stdout, values)
 
 #------------------------------------------------------------------------------
 # genSentenceBreakPropertyTable
 #------------------------------------------------------------------------------
 
-def genSentenceBreakPropertyTable(ucd):
+@functools.lru_cache(maxsize=None)
+def sentenceBreakValues(ucd):
     fin = open(ucd + '/auxiliary/SentenceBreakProperty.txt')
 
     defval = 'Unassigned'
@@ -886,13 +1063,18 @@ def genSentenceBreakPropertyTable(ucd):
             else:
                 values[codePoint] = value
 
-    generateTable('_sentence_break_properties', 'SentenceBreak', defval, sys.stdout, values)
+    return values
+
+def genSentenceBreakPropertyTable(ucd):
+    values = sentenceBreakValues(ucd)
+    generateTable('_sentence_break_properties', 'SentenceBreak', 'Unassigned', sys.stdout, values)
 
 #------------------------------------------------------------------------------
 # genEmojiPropertyTable
 #------------------------------------------------------------------------------
 
-def genEmojiPropertyTable(ucd):
+@functools.lru_cache(maxsize=None)
+def emojiValues(ucd):
     fin = open(ucd + '/emoji/emoji-data.txt')
 
     defval = 'Unassigned'
@@ -912,13 +1094,18 @@ def genEmojiPropertyTable(ucd):
             else:
                 values[codePoint] = value
 
-    generateTable('_emoji_properties', 'Emoji', defval, sys.stdout, values)
+    return values
+
+def genEmojiPropertyTable(ucd):
+    values = emojiValues(ucd)
+    generateTable('_emoji_properties', 'Emoji', 'Unassigned', sys.stdout, values)
 
 #------------------------------------------------------------------------------
 # genEastAsianWidthPropertyTable
 #------------------------------------------------------------------------------
 
-def genEastAsianWidthPropertyTable(ucd):
+@functools.lru_cache(maxsize=None)
+def eastAsianWidthValues(ucd):
     fin = open(ucd + '/EastAsianWidth.txt')
 
     # Map the short property values in the data file to the descriptive enum
@@ -964,7 +1151,48 @@ def genEastAsianWidthPropertyTable(ucd):
             else:
                 values[codePoint] = value
 
-    generateTable('_east_asian_width_properties', 'EastAsianWidth', defval, sys.stdout, values)
+    return values
+
+def genEastAsianWidthPropertyTable(ucd):
+    values = eastAsianWidthValues(ucd)
+    generateTable('_east_asian_width_properties', 'EastAsianWidth', 'Neutral', sys.stdout, values)
+
+#------------------------------------------------------------------------------
+# genCharInfoTable
+#------------------------------------------------------------------------------
+
+def genCharInfoTable(ucd):
+    columns = zip(
+        propertyValues(ucd),
+        derivedCorePropertyValues(ucd),
+        blockValues(ucd),
+        scriptValues(ucd),
+        generalCategoryValues(ucd),
+        graphemeBreakValues(ucd),
+        wordBreakValues(ucd),
+        sentenceBreakValues(ucd),
+        emojiValues(ucd),
+        eastAsianWidthValues(ucd),
+        [cls for cls, compat, codes in normalizationPropertyValues(ucd)])
+
+    # Record 0 holds the default of every property, so it is also the answer
+    # for code points beyond U+10FFFF.
+    defrec = (0, 0, 'Unassigned', 'Unassigned', 'Cn', 'Unassigned',
+              'Unassigned', 'Unassigned', 'Unassigned', 'Neutral', 0)
+    records = {defrec: 0}
+    values = [records.setdefault(rec, len(records)) for rec in columns]
+
+    if len(records) > 0xFFFF:
+        sys.exit('error: too many distinct character records')
+
+    print("inline constexpr CharInfo _char_info_records[] = {")
+    for rec in records:
+        print('{ 0x%016X, 0x%08X, Block::%s, Script::%s, GeneralCategory::%s, '
+              'GraphemeBreak::%s, WordBreak::%s, SentenceBreak::%s, Emoji::%s, '
+              'EastAsianWidth::%s, %d },' % rec)
+    print("};")
+
+    generateTable('_char_info_indexes', 'uint16_t', 0, sys.stdout, values)
 
 #------------------------------------------------------------------------------
 # Main
@@ -991,3 +1219,4 @@ else:
     genSentenceBreakPropertyTable(ucd)
     genEmojiPropertyTable(ucd)
     genEastAsianWidthPropertyTable(ucd)
+    genCharInfoTable(ucd)
@@ -122,6 +122,44 @@ TEST_CASE("Derived property", "[derived property]") {
   REQUIRE(is_alphabetic(U'+') == false);
 }
 
+//-----------------------------------------------------------------------------
+// Character Record
+//-----------------------------------------------------------------------------
+
+TEST_CASE("Character record", "[character record]") {
+  for (char32_t cp = 0; cp <= 0x110000; cp++) {
+    const auto &ci = char_info(cp);
+    REQUIRE(ci.general_category == general_category(cp));
+    REQUIRE(ci.block == block(cp));
+    REQUIRE(ci.script == script(cp));
+    REQUIRE(ci.east_asian_width == east_asian_width(cp));
+    REQUIRE(ci.combining_class == combining_class(cp));
+    REQUIRE(!!(ci.properties & Property_White_Space) == is_white_space(cp));
+    REQUIRE(!!(ci.derived_properties & DerivedProperty_Alphabetic) ==
+            is_alphabetic(cp));
+    REQUIRE(!!(ci.derived_properties & DerivedProperty_Cased) == is_cased(cp));
+    REQUIRE(ci.emoji == _emoji_properties::get_value(cp));
+  }
+
+  REQUIRE(char_info(U'a').grapheme_break == GraphemeBreak::Unassigned);
+  REQUIRE(char_info(0x200D).grapheme_break == GraphemeBreak::ZWJ);
+  REQUIRE(char_info(U'a').word_break == WordBreak::ALetter);
+  REQUIRE(char_info(U'.').sentence_break == SentenceBreak::ATerm);
+  REQUIRE(char_info(0xFFFFFFFF).general_category ==
+          GeneralCategory::Unassigned);
+}
+
+TEST_CASE("Property value storage", "[character record]") {
+  STATIC_REQUIRE(sizeof(GeneralCategory) == 1);
+  STATIC_REQUIRE(sizeof(Block) == 2);
+  STATIC_REQUIRE(sizeof(Script) == 1);
+  STATIC_REQUIRE(sizeof(GraphemeBreak) == 1);
+  STATIC_REQUIRE(sizeof(WordBreak) == 1);
+  STATIC_REQUIRE(sizeof(SentenceBreak) == 1);
+  STATIC_REQUIRE(sizeof(Emoji) == 1);
+  STATIC_REQUIRE(sizeof(EastAsianWidth) == 1);
+}
+
 //-----------------------------------------------------------------------------
 // Case
 //-----------------------------------------------------------------------------
@@ -180,6 +218,13 @@ TEST_CASE("Simple case mapping", "[case]") {
   REQUIRE(simple_titlecase_mapping(U'Ǳ') == U'ǲ');
   REQUIRE(simple_titlecase_mapping(U'ǲ') == U'ǲ');
   REQUIRE(simple_titlecase_mapping(U'ǳ') == U'ǲ');
+
+  // Mappings whose distance does not fit in 16 bits.
+  REQUIRE(simple_lowercase_mapping(0xA7AE) == 0x026A);
+  REQUIRE(simple_uppercase_mapping(0x026A) == 0xA7AE);
+
+  REQUIRE(simple_uppercase_mapping(0x110000) == 0x110000);
+  REQUIRE(simple_lowercase_mapping(0xFFFFFFFF) == 0xFFFFFFFF);
 }
 
 TEST_CASE("Simple case folding", "[case]") {
@@ -272,6 +317,14 @@ TEST_CASE("Full case mapping", "[case]") {
 
 TEST_CASE("Full case folding", "[case]") {
   REQUIRE(to_case_fold(U"heiss") == to_case_fold(U"heiß"));
+  REQUIRE(to_case_fold(U"ßİﬃ") == U"ssi\u0307ffi");
+  REQUIRE(to_case_fold(U"AΣﬀ") == U"aσff");
+
+  REQUIRE(to_case_fold(U"Iİ") == U"ii\u0307");
+  REQUIRE(to_case_fold(U"Iİ", CaseTailoring::TurkicCaseFold) == U"ıi");
+
+  REQUIRE(to_case_fold(std::u32string(1, 0x110000)) ==
+          std::u32string(1, 0x110000));
 }
 
 TEST_CASE("Casless match", "[case]") {
@@ -317,6 +370,78 @@ TEST_CASE("case detection", "[case]") {
   REQUIRE(is_case_fold(U"heiß") == false);
 }
 
+TEST_CASE("Case mapping of UTF-8", "[case]") {
+  REQUIRE(to_uppercase(u8"Straße, ΌΣΟΣ hello") == u8"STRASSE, ΌΣΟΣ HELLO");
+  REQUIRE(to_lowercase(u8"ΌΣΟΣ HELLO") == u8"όσος hello");
+  REQUIRE(to_titlecase(u8"hello wORLD ǆemal") == u8"Hello World ǅemal");
+  REQUIRE(to_case_fold(u8"Heiß ﬃ ΣΑΣ") == u8"heiss ffi σασ");
+
+  // Tailorings that touch ASCII letters
+  REQUIRE(to_uppercase("istanbul", "tr") == u8"İSTANBUL");
+  REQUIRE(to_lowercase(u8"ISTANBUL İ", "tr") == u8"ıstanbul i");
+  REQUIRE(to_lowercase(u8"\u00CC", "lt") == u8"i\u0307\u0300");
+  REQUIRE(to_titlecase("ijsje", "nl") == "IJsje");
+  REQUIRE(to_case_fold("Iİ", CaseTailoring::TurkicCaseFold) == u8"ıi");
+
+  // Long ASCII runs around other text
+  std::string text = "The Quick Brown Fox Jumps Over The Lazy Dog 0123 [@`{]";
+  text += u8"Ça";
+  text += text;
+  auto s32 = to_lowercase(utf8::decode(text));
+  REQUIRE(to_lowercase(text) == utf8::encode(s32));
+  s32 = to_uppercase(utf8::decode(text));
+  REQUIRE(to_uppercase(text) == utf8::encode(s32));
+
+  // The result is appended, and ill-formed input reads as U+FFFD.
+  std::string out = "key:";
+  to_case_fold("A\xE2\x82" "B", 4, out);
+  REQUIRE(out == u8"key:a�b");
+  out.clear();
+  to_uppercase("abc", 3, out);
+  REQUIRE(out == "ABC");
+}
+
+TEST_CASE("Case mapping into a buffer", "[case]") {
+  std::u32string out = U"key:";
+  std::u32string_view s32 = U"Straße ΌΣΟΣ";
+  to_case_fold(s32.data(), s32.length(), out);
+  REQUIRE(out == U"key:strasse όσοσ");
+
+  // Cleared and reused, the buffer is not reallocated.
+  const auto data = out.data();
+  out.clear();
+  to_uppercase(s32.data(), s32.length(), out);
+  REQUIRE(out == U"STRASSE ΌΣΟΣ");
+  out.clear();
+  to_lowercase(s32.data(), s32.length(), out);
+  REQUIRE(out == U"straße όσος");
+  out.clear();
+  s32 = U"ijsje";
+  to_titlecase(s32.data(), s32.length(), out, "nl");
+  REQUIRE(out == U"IJsje");
+  REQUIRE(out.data() == data);
+
+  // No character maps to more than max_case_mapping_length(1) code points.
+  size_t longest = 0;
+  for (char32_t cp = 0; cp <= 0x10FFFF; cp++) {
+    for (auto locale : {"", "tr", "lt"}) {
+      out.clear();
+      to_uppercase(&cp, 1, out, locale);
+      longest = std::max(longest, out.size());
+      out.clear();
+      to_lowercase(&cp, 1, out, locale);
+      longest = std::max(longest, out.size());
+      out.clear();
+      to_titlecase(&cp, 1, out, locale);
+      longest = std::max(longest, out.size());
+    }
+    out.clear();
+    to_case_fold(&cp, 1, out);
+    longest = std::max(longest, out.size());
+  }
+  REQUIRE(longest == max_case_mapping_length(1));
+}
+
 //-----------------------------------------------------------------------------
 // Text Segmentation
 //-----------------------------------------------------------------------------
@@ -448,6 +573,86 @@ TEST_CASE("Sentence segmentation", "[segmentation]") {
       });
 }
 
+template <typename IsBoundary, typename NextBoundary>
+void check_utf8_segmentation(const char *path, IsBoundary is_boundary,
+                             NextBoundary next_boundary) {
+  read_text_segmentation_test_file(
+      path, [&](const auto &s32, const auto &boundary, auto /*expected_count*/,
+                auto /*ln*/) {
+        std::string s8;
+        std::vector<size_t> offsets{0};
+        for (auto cp : s32) {
+          utf8::encode_codepoint(cp, s8);
+          offsets.push_back(s8.size());
+        }
+
+        std::vector<size_t> expected;
+        for (auto i = 0u; i < boundary.size(); i++) {
+          CHECK(boundary[i] == is_boundary(s8.data(), s8.size(), offsets[i]));
+          if (boundary[i] && i > 0) {
+            expected.push_back(offsets[i]);
+          }
+        }
+
+        std::vector<size_t> actual;
+        for (size_t i = 0; i < s8.size();) {
+          i = next_boundary(s8.data(), s8.size(), i);
+          actual.push_back(i);
+        }
+        CHECK(expected == actual);
+      });
+}
+
+TEST_CASE("Text segmentation of UTF-8", "[segmentation]") {
+  check_utf8_segmentation(
+      "../UCD/auxiliary/GraphemeBreakTest.txt",
+      [](auto s8, auto l, auto i) { return is_grapheme_boundary(s8, l, i); },
+      [](auto s8, auto l, auto i) { return next_grapheme_boundary(s8, l, i); });
+  check_utf8_segmentation(
+      "../UCD/auxiliary/WordBreakTest.txt",
+      [](auto s8, auto l, auto i) { return is_word_boundary(s8, l, i); },
+      [](auto s8, auto l, auto i) { return next_word_boundary(s8, l, i); });
+  check_utf8_segmentation(
+      "../UCD/auxiliary/SentenceBreakTest.txt",
+      [](auto s8, auto l, auto i) { return is_sentence_boundary(s8, l, i); },
+      [](auto s8, auto l, auto i) { return next_sentence_boundary(s8, l, i); });
+}
+
+TEST_CASE("Text segmentation of UTF-8 with byte offsets", "[segmentation]") {
+  std::string s8 = u8"Don't panic.\r\nHé said 3.14! \U0001F1EF\U0001F1F5";
+
+  std::vector<size_t> words;
+  for (size_t i = 0; i < s8.size();) {
+    i = next_word_boundary(s8.data(), s8.size(), i);
+    words.push_back(i);
+  }
+  REQUIRE(words == std::vector<size_t>{5, 6, 11, 12, 14, 17, 18, 22, 23,
+                                       27, 28, 29, 37});
+
+  std::vector<size_t> sentences;
+  for (size_t i = 0; i < s8.size();) {
+    i = next_sentence_boundary(s8.data(), s8.size(), i);
+    sentences.push_back(i);
+  }
+  REQUIRE(sentences == std::vector<size_t>{14, 29, 37});
+
+  // U+00E9 takes bytes 15 and 16, and the flag bytes 29 to 36.
+  REQUIRE(is_grapheme_boundary(s8.data(), s8.size(), 15));
+  REQUIRE_FALSE(is_grapheme_boundary(s8.data(), s8.size(), 16));
+  REQUIRE_FALSE(is_grapheme_boundary(s8.data(), s8.size(), 13));  // CR LF
+  REQUIRE_FALSE(is_grapheme_boundary(s8.data(), s8.size(), 33));
+  REQUIRE(grapheme_count(s8.data(), s8.size()) == 28);
+
+  // Each maximal subpart of ill-formed input is one U+FFFD.
+  std::string bad = "a\xE2\x82z\x80";
+  REQUIRE(next_grapheme_boundary(bad.data(), bad.size(), 0) == 1);
+  REQUIRE(next_grapheme_boundary(bad.data(), bad.size(), 1) == 3);
+  REQUIRE(next_grapheme_boundary(bad.data(), bad.size(), 3) == 4);
+  REQUIRE(next_grapheme_boundary(bad.data(), bad.size(), 4) == 5);
+  REQUIRE_FALSE(is_grapheme_boundary(bad.data(), bad.size(), 2));
+  REQUIRE(grapheme_count(bad.data(), bad.size()) == 4);
+}
+
 //-----------------------------------------------------------------------------
 // Block
 //-----------------------------------------------------------------------------
@@ -471,6 +676,10 @@ TEST_CASE("Script extension", "[script]") {
   REQUIRE(is_script(Script::Hiragana, U'ー'));
   REQUIRE(is_script(Script::Katakana, U'ー'));
   REQUIRE(is_script(Script::Latin, U'ー') == false);
+  REQUIRE(is_script(Script::Devanagari, 0x0964));  // DEVANAGARI DANDA
+  REQUIRE(is_script(Script::Bengali, 0x0964));
+  REQUIRE(is_script(Script::Latin, 0x0964) == false);
+  REQUIRE(is_script(Script::Latin, U'a'));
 }
 
 //-----------------------------------------------------------------------------
@@ -489,6 +698,21 @@ TEST_CASE("Hangul composition boundary", "[normalization]") {
   REQUIRE(to_nfc(U"\uAC00\u11C3") == U"\uAC00\u11C3");
 }
 
+TEST_CASE("Full decomposition", "[normalization]") {
+  // U+01D5 -> U+00DC U+0304 -> U+0055 U+0308 U+0304
+  REQUIRE(to_nfd(U"\u01D5") == U"U\u0308\u0304");
+  // U+1E9B decomposes canonically to U+017F U+0307, and U+017F has a
+  // compatibility mapping to 's'.
+  REQUIRE(to_nfd(U"\u1E9B") == U"\u017F\u0307");
+  REQUIRE(to_nfkd(U"\u1E9B") == U"s\u0307");
+  REQUIRE(to_nfkd(U"\uFDFA").length() == 18);
+  REQUIRE(to_nfd(U"\uFDFA") == U"\uFDFA");
+
+  // Unassigned code points are starters.
+  REQUIRE(combining_class(0x0590) == 0);
+  REQUIRE(combining_class(0x0591) == 220);
+}
+
 TEST_CASE("Normalization", "[normalization]") {
   ifstream fs("../UCD/NormalizationTest.txt");
   REQUIRE(fs);
@@ -551,7 +775,302 @@ TEST_CASE("Normalization", "[normalization]") {
     REQUIRE(c5 == to_nfkd(c3));
     REQUIRE(c5 == to_nfkd(c4));
     REQUIRE(c5 == to_nfkd(c5));
+
+    // Normalization into a caller-provided buffer
+    {
+      u32string buf;
+      REQUIRE(normalize(Normalization::NFC, c1, buf) == c2);
+      REQUIRE(normalize(Normalization::NFD, c1, buf) == c3);
+      REQUIRE(normalize(Normalization::NFKC, c1, buf) == c4);
+      REQUIRE(normalize(Normalization::NFKD, c1, buf) == c5);
+    }
+
+    // Normalization of UTF-8
+    {
+      auto s1 = utf8::encode(c1);
+      REQUIRE(to_nfc(s1) == utf8::encode(c2));
+      REQUIRE(to_nfd(s1) == utf8::encode(c3));
+      REQUIRE(to_nfkc(s1) == utf8::encode(c4));
+      REQUIRE(to_nfkd(s1) == utf8::encode(c5));
+    }
+
+    // Normalization check
+    for (const auto &c : {c1, c2, c3, c4, c5}) {
+      REQUIRE(is_nfc(c) == (c == to_nfc(c)));
+      REQUIRE(is_nfd(c) == (c == to_nfd(c)));
+      REQUIRE(is_nfkc(c) == (c == to_nfkc(c)));
+      REQUIRE(is_nfkd(c) == (c == to_nfkd(c)));
+    }
+  }
+}
+
+TEST_CASE("Normalization quick check", "[normalization]") {
+  REQUIRE(quick_check(Normalization::NFC, U"abc") == QuickCheck::Yes);
+  REQUIRE(quick_check(Normalization::NFD, U"abc") == QuickCheck::Yes);
+  REQUIRE(quick_check(Normalization::NFC, U"") == QuickCheck::Yes);
+
+  // U+00E9 is NFC but not NFD.
+  REQUIRE(quick_check(Normalization::NFC, U"\u00E9") == QuickCheck::Yes);
+  REQUIRE(quick_check(Normalization::NFD, U"\u00E9") == QuickCheck::No);
+
+  // U+0301 may compose with what precedes it.
+  REQUIRE(quick_check(Normalization::NFC, U"e\u0301") == QuickCheck::Maybe);
+  REQUIRE(quick_check(Normalization::NFD, U"e\u0301") == QuickCheck::Yes);
+  REQUIRE(is_nfc(U"e\u0301") == false);
+  REQUIRE(is_nfc(U"x\u0301") == true);
+  REQUIRE(is_nfc(U"abc x\u0301 e\u0301") == false);
+
+  // Hangul: LV syllable + T composes, L + V does too.
+  REQUIRE(quick_check(Normalization::NFC, U"\uAC00\u11A8") ==
+          QuickCheck::Maybe);
+  REQUIRE(is_nfc(U"\uAC00\u11A8") == false);
+  REQUIRE(is_nfc(U"\u1100\u1161") == false);
+  REQUIRE(is_nfd(U"\uAC00") == false);
+
+  // Singletons and composition exclusions are never NFC.
+  REQUIRE(quick_check(Normalization::NFC, U"\u212B") == QuickCheck::No);
+  REQUIRE(quick_check(Normalization::NFC, U"\u0958") == QuickCheck::No);
+
+  // Compatibility characters.
+  REQUIRE(quick_check(Normalization::NFC, U"\uFB01") == QuickCheck::Yes);
+  REQUIRE(quick_check(Normalization::NFKC, U"\uFB01") == QuickCheck::No);
+  REQUIRE(quick_check(Normalization::NFKD, U"\uFB01") == QuickCheck::No);
+
+  // Combining marks out of canonical order.
+  REQUIRE(quick_check(Normalization::NFD, U"a\u0301\u0323") ==
+          QuickCheck::No);
+  REQUIRE(quick_check(Normalization::NFD, U"a\u0323\u0301") ==
+          QuickCheck::Yes);
+
+  REQUIRE(is_nfc(U"\U00110000") == true);
+}
+
+TEST_CASE("Normalization without copying", "[normalization]") {
+  std::u32string buf;
+
+  // Already normalized input is returned as is.
+  std::u32string_view s1 = U"abc e\u0301x";
+  auto r1 = normalize(Normalization::NFD, s1, buf);
+  REQUIRE(r1.data() == s1.data());
+  REQUIRE(r1.length() == s1.length());
+
+  // A 'Maybe' segment that turns out to be normalized does not copy either.
+  std::u32string_view s2 = U"abc x\u0301";
+  REQUIRE(normalize(Normalization::NFC, s2, buf).data() == s2.data());
+
+  std::u32string_view s3 = U"abc e\u0301 \u212B xyz";
+  auto r3 = normalize(Normalization::NFC, s3, buf);
+  REQUIRE(r3.data() == buf.data());
+  REQUIRE(r3 == U"abc \u00E9 \u00C5 xyz");
+
+  std::u32string_view s4 = U"a\u0301\u0323b";
+  REQUIRE(normalize(Normalization::NFD, s4, buf) == U"a\u0323\u0301b");
+  REQUIRE(normalize(Normalization::NFC, s4, buf) == U"\u1EA1\u0301b");
+
+  std::u32string_view s5 = U"";
+  REQUIRE(normalize(Normalization::NFC, s5, buf).empty());
+}
+
+TEST_CASE("Canonical reordering of long runs", "[normalization]") {
+  // Runs longer than the ones sorted on the stack, interleaved so that each
+  // class keeps its own order.
+  std::u32string s32 = U"a";
+  std::u32string below, above;
+  for (auto i = 0; i < 40; i++) {
+    s32 += U"\u0301\u0316";
+    below += U'\u0316';
+    above += U'\u0301';
+  }
+  s32 += U"\u0323\u0300b";
+  REQUIRE(to_nfd(s32) == U"a" + below + U"\u0323" + above + U"\u0300b");
+  REQUIRE(to_nfc(s32) ==
+          U"\u00E1" + below + U"\u0323" + above.substr(1) + U"\u0300b");
+}
+
+TEST_CASE("Stream-Safe Text Format", "[normalization]") {
+  std::u32string marks(30, U'\u0301');
+  const auto fewer = marks.substr(1);
+
+  REQUIRE(is_stream_safe(U"a" + marks));
+  REQUIRE_FALSE(is_stream_safe(U"a" + marks + U"\u0301"));
+  REQUIRE(is_stream_safe(U"a" + marks + U"b" + marks));
+  // Non-starters are counted in NFKD: U+0344 is two of them, and U+00A8
+  // (DIAERESIS) ends with one.
+  REQUIRE_FALSE(is_stream_safe(U"a" + fewer + U"\u0344"));
+  REQUIRE_FALSE(is_stream_safe(U"\u00A8" + marks));
+  REQUIRE(is_stream_safe(U"\u00A8" + fewer));
+
+  std::string marks8;
+  for (auto i = 0; i < 30; i++) {
+    marks8 += u8"\u0301";
   }
+  const auto fewer8 = marks8.substr(2);
+  REQUIRE(is_stream_safe("a" + marks8));
+  REQUIRE_FALSE(is_stream_safe("a" + marks8 + u8"\u0301"));
+  REQUIRE_FALSE(is_stream_safe(u8"\u00A8" + marks8));
+
+  const auto options = NormalizationOptions::StreamSafe;
+  REQUIRE(to_nfd(U"a" + marks + U"\u0316", options) ==
+          U"a" + marks + U"\u034F\u0316");
+  REQUIRE(to_nfc(U"a" + marks + U"\u0301", options) ==
+          U"\u00E1" + fewer + U"\u034F\u0301");
+  REQUIRE(to_nfkc(U"\u00A8" + marks, options) ==
+          U" \u0308" + fewer + U"\u034F\u0301");
+  REQUIRE(to_nfd(U"a" + marks, options) == U"a" + marks);
+
+  REQUIRE(to_nfd("a" + marks8 + u8"\u0316", options) ==
+          "a" + marks8 + u8"\u034F\u0316");
+  std::string buf;
+  REQUIRE(normalize(Normalization::NFC, "a" + marks8 + u8"\u0301", buf,
+                    options) ==
+          u8"\u00E1" + fewer8 + u8"\u034F\u0301");
+
+  // Making the text stream-safe changes it, even when it is normalized.
+  auto long_run = "a" + marks8 + u8"\u0301";
+  REQUIRE(normalize(Normalization::NFD, long_run, buf) == long_run);
+  REQUIRE(normalize(Normalization::NFD, long_run, buf, options) ==
+          "a" + marks8 + u8"\u034F\u0301");
+}
+
+TEST_CASE("Normalizer", "[normalization]") {
+  Normalizer nfc(Normalization::NFC);
+  Normalizer nfkd(Normalization::NFKD);
+
+  std::u32string_view inputs[] = {
+      U"",          U"abc",           U"e\u0301",          U"\u1E9B\u0323",
+      U"\uAC00\u11A8", U"\u0041\u030A\u0327", U"\uFB01 \u2460",
+  };
+  for (auto s32 : inputs) {
+    REQUIRE(nfc.normalize(s32) == to_nfc(s32));
+    REQUIRE(nfkd.normalize(s32) == to_nfkd(s32));
+    REQUIRE(nfc.is_normalized(s32) == is_nfc(s32));
+
+    auto s8 = utf8::encode(s32);
+    REQUIRE(nfc.normalize(s8) == to_nfc(s8));
+    REQUIRE(nfkd.normalize(s8) == to_nfkd(s8));
+
+    std::string out = "<";
+    nfkd.append(s8.data(), s8.length(), out);
+    REQUIRE(out.substr(0, 1) == "<");
+    REQUIRE(out.substr(1) == to_nfkd(s8));
+  }
+
+  // Normalized input is returned as is.
+  std::u32string_view s32 = U"caf\u00E9";
+  REQUIRE(nfc.normalize(s32).data() == s32.data());
+  std::string_view s8 = u8"caf\u00E9";
+  REQUIRE(nfc.normalize(s8).data() == s8.data());
+
+  Normalizer safe(Normalization::NFD, NormalizationOptions::StreamSafe);
+  std::u32string marks(31, U'\u0301');
+  REQUIRE_FALSE(safe.is_normalized(U"a" + marks));
+  REQUIRE(safe.normalize(U"a" + marks) ==
+          U"a" + marks.substr(1) + U"\u034F\u0301");
+  REQUIRE(safe.is_normalized(U"a" + marks.substr(1)));
+}
+
+TEST_CASE("Normalization into a buffer", "[normalization]") {
+  std::u32string out = U"<";
+  std::u32string_view s32 = U"e\u0301\uFB01";
+  to_nfc(s32.data(), s32.length(), out);
+  REQUIRE(out == U"<\u00E9\uFB01");
+  to_nfkd(s32.data(), s32.length(), out);
+  REQUIRE(out == U"<\u00E9\uFB01e\u0301fi");
+
+  // Cleared and reused, the buffer is not reallocated.
+  const auto data = out.data();
+  out.clear();
+  to_nfd(s32.data(), s32.length(), out);
+  REQUIRE(out == s32);
+  out.clear();
+  to_nfkc(s32.data(), s32.length(), out);
+  REQUIRE(out == U"\u00E9fi");
+  REQUIRE(out.data() == data);
+
+  Normalizer nfc(Normalization::NFC);
+  out.clear();
+  nfc.append(s32.data(), s32.length(), out);
+  REQUIRE(out == U"\u00E9\uFB01");
+
+  // No code point normalizes to more than max_normalized_length(norm, 1).
+  for (auto n = 0; n < 4; n++) {
+    const auto norm = static_cast<Normalization>(n);
+    Normalizer normalizer(norm);
+    size_t longest = 0;
+    for (char32_t cp = 0; cp <= 0x10FFFF; cp++) {
+      out.clear();
+      normalizer.append(&cp, 1, out);
+      longest = std::max(longest, out.size());
+    }
+    REQUIRE(longest == max_normalized_length(norm, 1));
+  }
+}
+
+TEST_CASE("Normalization of UTF-8", "[normalization]") {
+  std::string buf;
+
+  // Already normalized input is returned as is.
+  std::string_view s1 = u8"abc \u00E9x \u00C0 \u4E00";
+  REQUIRE(normalize(Normalization::NFC, s1, buf).data() == s1.data());
+  REQUIRE(normalize(Normalization::NFKC, s1, buf).data() == s1.data());
+
+  std::string_view s2 = u8"abc e\u0301 \u212B xyz";
+  auto r2 = normalize(Normalization::NFC, s2, buf);
+  REQUIRE(r2.data() == buf.data());
+  REQUIRE(r2 == u8"abc \u00E9 \u00C5 xyz");
+  REQUIRE(to_nfd(s2) == u8"abc e\u0301 A\u030A xyz");
+  REQUIRE(to_nfkc(u8"\uFB01 \u00BD") == u8"fi 1\u20442");
+
+  std::string_view s3 = u8"a\u0301\u0323b";
+  REQUIRE(normalize(Normalization::NFD, s3, buf) == u8"a\u0323\u0301b");
+  REQUIRE(normalize(Normalization::NFC, s3, buf) == u8"\u1EA1\u0301b");
+
+  // Ill-formed input is replaced with U+FFFD, and the result is appended.
+  std::string out = "x";
+  to_nfc("e\xCC\x81\xCC", 4, out);
+  REQUIRE(out == u8"x\u00E9\uFFFD");
+  REQUIRE(normalize(Normalization::NFD, "a\x80", buf) == u8"a\uFFFD");
+
+  REQUIRE(normalize(Normalization::NFC, std::string_view(), buf).empty());
+
+  // Code points with a lead byte below min_unstable_lead_byte() are passed
+  // over without a lookup, so all of them have to be stable.
+  for (auto n = 0; n < 4; n++) {
+    const auto norm = static_cast<Normalization>(n);
+    const char32_t end = (min_unstable_lead_byte(norm) - 0xC0u) << 6;
+    auto stable = true;
+    for (char32_t cp = 0; cp < end; cp++) {
+      stable = stable && is_stable_code(cp, norm);
+    }
+    REQUIRE(stable);
+
+    // And the threshold is as low as it can be.
+    for (char32_t cp = end; cp < end + 0x40; cp++) {
+      stable = stable && is_stable_code(cp, norm);
+    }
+    REQUIRE_FALSE(stable);
+  }
+}
+
+TEST_CASE("Canonical composition", "[normalization]") {
+  // Hangul L+V and LV+T compose pairwise; TBase (U+11A7) is not a trailer.
+  REQUIRE(to_nfc(U"\u1100\u1161\u11A8") == U"\uAC01");
+  REQUIRE(to_nfc(U"\uAC00\u11A8") == U"\uAC01");
+  REQUIRE(to_nfc(U"\uAC00\u11A7") == U"\uAC00\u11A7");
+  REQUIRE(to_nfc(U"\uAC01\u11A8") == U"\uAC01\u11A8");
+
+  // Blocked and unblocked marks after the same starter.
+  REQUIRE(to_nfc(U"a\u0323\u0302") == U"\u1EAD");
+  REQUIRE(to_nfc(U"a\u0301\u0301") == U"\u00E1\u0301");
+  REQUIRE(to_nfc(U"\u0301a") == U"\u0301a");
+
+  // A long run of marks is reordered and composed in one segment.
+  std::u32string s = U"e";
+  for (int i = 0; i < 100; i++) {
+    s += U"\u0302\u0323";
+  }
+  REQUIRE(to_nfc(s) == U"\u1EC7" + std::u32string(99, U'\u0323') +
+                           std::u32string(99, U'\u0302'));
 }
 
 //-----------------------------------------------------------------------------
@@ -688,6 +1207,57 @@ TEST_CASE("decode drops ill-formed sequences and resyncs", "[utf8]") {
   REQUIRE(utf8::decode("\xF4\x90\x80\x80" "A") == U"A");  // U+110000
 }
 
+TEST_CASE("decode long text", "[utf8]") {
+  // Long enough for the SIMD kernels; ill-formed bytes anywhere are dropped
+  // without disturbing the code points around them.
+  std::string text(100, 'x');
+  std::u32string expected(100, U'x');
+  std::vector<size_t> boundaries;
+  for (int i = 0; i < 20; i++) {
+    for (auto s : {"a", "\xC3\xA9", "\xE6\x97\xA5", "\xF0\x9F\x98\x80"}) {
+      boundaries.push_back(text.size());
+      text += s;
+    }
+    expected += U"aé日\U0001F600";
+  }
+  REQUIRE(utf8::decode(text) == expected);
+
+  for (auto pos : boundaries) {
+    for (auto bad : {"\x80", "\xC1\xBF", "\xED\xA0\x80", "\xF5\x80\x80\x80",
+                     "\xE6\x97"}) {
+      auto s = text;
+      s.insert(pos, bad);
+      REQUIRE(utf8::decode(s) == expected);
+    }
+  }
+
+  std::u32string out = U"prefix";
+  utf8::decode(text, out);
+  REQUIRE(out == U"prefix" + expected);
+}
+
+TEST_CASE("encode long text", "[utf8]") {
+  // Runs of ASCII long enough for the SIMD kernels, with every kind of code
+  // point, and the ones encode_codepoint drops, at each position after them.
+  std::u32string ascii(40, U'x');
+  for (auto cp : {U'a', U'\u00E9', U'\u65E5', U'\U0001F600', char32_t(0xD800),
+                  char32_t(0xDFFF), char32_t(0x110000)}) {
+    for (size_t pos = 0; pos <= ascii.size(); pos++) {
+      auto s32 = ascii;
+      s32.insert(pos, 1, cp);
+      std::string expected;
+      for (auto c : s32) {
+        utf8::encode_codepoint(c, expected);
+      }
+      REQUIRE(utf8::exact_encoded_length(s32.data(), s32.size()) ==
+              expected.size());
+      std::string out = "prefix";
+      utf8::encode(s32, out);
+      REQUIRE(out == "prefix" + expected);
+    }
+  }
+}
+
 TEST_CASE("codepoint_length consistent with decode_codepoint", "[utf8]") {
   REQUIRE(utf8::codepoint_length("\xE3\x81", 2) == 0);      // truncated
   REQUIRE(utf8::codepoint_length("\x80", 1) == 0);          // continuation byte
@@ -701,6 +1271,293 @@ TEST_CASE("codepoint_count with ill-formed input", "[utf8]") {
   REQUIRE(utf8::codepoint_count("\xF0" "Hello", 6) == 5);
 }
 
+TEST_CASE("validate", "[utf8]") {
+  REQUIRE(utf8::validate("") == 0);
+  REQUIRE(utf8::validate(u8text) == u8text.size());
+  REQUIRE(utf8::validate("a\x80" "b") == 1);
+  REQUIRE(utf8::validate("ab\xC0\xAF") == 2);           // overlong
+  REQUIRE(utf8::validate("\xED\xA0\x80") == 0);         // surrogate
+  REQUIRE(utf8::validate("\xF4\x8F\xBF\xBF") == 4);     // U+10FFFF
+  REQUIRE(utf8::validate("\xF4\x90\x80\x80") == 0);     // U+110000
+  REQUIRE(utf8::validate("abc\xE3\x81") == 3);          // truncated
+}
+
+TEST_CASE("validate long text", "[utf8]") {
+  // Long enough for the SIMD kernels; every error position and every
+  // truncation point must be reported exactly.
+  std::string text;
+  std::vector<size_t> boundaries;
+  for (int i = 0; i < 20; i++) {
+    for (auto s : {"a", "\xC3\xA9", "\xE6\x97\xA5", "\xF0\x9F\x98\x80"}) {
+      boundaries.push_back(text.size());
+      text += s;
+    }
+  }
+  REQUIRE(utf8::validate(text) == text.size());
+
+  for (auto pos : boundaries) {
+    for (auto bad : {"\x80", "\xC1\xBF", "\xED\xA0\x80", "\xF5\x80\x80\x80",
+                     "\xE6\x97"}) {
+      auto s = text;
+      s.insert(pos, bad);
+      REQUIRE(utf8::validate(s) == pos);
+    }
+    REQUIRE(utf8::validate(text.data(), pos) == pos);
+    REQUIRE(utf8::validate(text.data(), pos + 1) ==
+            (text[pos] == 'a' ? pos + 1 : pos));
+  }
+}
+
+TEST_CASE("decode into a caller buffer", "[utf8]") {
+  std::string text(100, 'x');
+  for (int i = 0; i < 20; i++) {
+    text += u8"aé日😀";
+  }
+  auto expected = utf8::decode(text);
+  REQUIRE(utf8::max_decoded_length(text.size()) >= expected.size());
+
+  std::u32string out(expected.size(), U'\0');
+  auto r = utf8::decode(text.data(), text.size(), &out[0], out.size());
+  REQUIRE(r.status == ConversionStatus::Ok);
+  REQUIRE(r.read == text.size());
+  REQUIRE(r.written == expected.size());
+  REQUIRE(out == expected);
+
+  // A small buffer fills up at a code point boundary; resuming from `read`
+  // produces the rest.
+  for (size_t cap = 1; cap <= 5; cap++) {
+    std::u32string got;
+    char32_t buff[5];
+    size_t i = 0;
+    while (true) {
+      r = utf8::decode(text.data() + i, text.size() - i, buff, cap);
+      REQUIRE(r.written <= cap);
+      got.append(buff, r.written);
+      i += r.read;
+      if (r.status != ConversionStatus::OutputFull) {
+        break;
+      }
+    }
+    REQUIRE(r.status == ConversionStatus::Ok);
+    REQUIRE(got == expected);
+  }
+
+  r = utf8::decode("a\x80" "b", 3, &out[0], out.size());
+  REQUIRE(r.status == ConversionStatus::IllFormed);
+  REQUIRE(r.read == 3);
+  REQUIRE(r.written == 2);
+}
+
+TEST_CASE("encode into a caller buffer", "[utf8]") {
+  std::u32string s32(40, U'x');
+  s32 += U"é日😀";
+  auto expected = utf8::encode(s32);
+
+  std::string out(expected.size(), '\0');
+  auto r = utf8::encode(s32.data(), s32.size(), &out[0], out.size());
+  REQUIRE(r.status == ConversionStatus::Ok);
+  REQUIRE(r.read == s32.size());
+  REQUIRE(out == expected);
+
+  // The emoji needs 4 bytes and does not fit in 3.
+  r = utf8::encode(s32.data(), s32.size(), &out[0], out.size() - 1);
+  REQUIRE(r.status == ConversionStatus::OutputFull);
+  REQUIRE(r.read == s32.size() - 1);
+  REQUIRE(r.written == expected.size() - 4);
+
+  s32 += char32_t(0xD800);
+  r = utf8::encode(s32.data(), s32.size(), &out[0], out.size());
+  REQUIRE(r.status == ConversionStatus::IllFormed);
+  REQUIRE(r.written == expected.size());
+}
+
+TEST_CASE("decode error policies", "[utf8]") {
+  // Maximal subparts: "\xF0\x9F\x98" is a truncated emoji, "\xED" cannot
+  // be followed by "\xA0", and "\x80" cannot start a sequence.
+  std::string text = "a\xF0\x9F\x98" "b\xED\xA0\x80" "c";
+
+  REQUIRE(utf8::decode(text, ErrorPolicy::Skip) == U"abc");
+  REQUIRE(utf8::decode(text, ErrorPolicy::Replace) ==
+          U"a\uFFFDb\uFFFD\uFFFD\uFFFDc");
+
+  std::u32string out;
+  auto r = utf8::decode(text, out, ErrorPolicy::Strict);
+  REQUIRE(r.status == ConversionStatus::IllFormed);
+  REQUIRE(r.read == 1);
+  REQUIRE(out == U"a");
+
+  out.clear();
+  r = utf8::decode(u8text, out, ErrorPolicy::Strict);
+  REQUIRE(r.status == ConversionStatus::Ok);
+  REQUIRE(r.read == u8text.size());
+  REQUIRE(out == u32text);
+
+  // The same inside long text, where the SIMD kernels do the bulk
+  std::string ascii(100, 'x');
+  std::u32string ascii32(100, U'x');
+  REQUIRE(utf8::decode(ascii + text + ascii, ErrorPolicy::Replace) ==
+          ascii32 + U"a\uFFFDb\uFFFD\uFFFD\uFFFDc" + ascii32);
+  out.clear();
+  r = utf8::decode(ascii + text + ascii, out, ErrorPolicy::Strict);
+  REQUIRE(r.read == 101);
+  REQUIRE(out == ascii32 + U"a");
+
+  std::u32string buff(8, U'\0');
+  r = utf8::decode(text.data(), text.size(), &buff[0], buff.size(),
+                   ErrorPolicy::Replace);
+  REQUIRE(r.status == ConversionStatus::IllFormed);
+  REQUIRE(r.read == text.size());
+  REQUIRE(r.written == 7);
+}
+
+TEST_CASE("StreamDecoder", "[utf8]") {
+  std::string text(40, 'x');
+  for (int i = 0; i < 10; i++) {
+    text += u8"aé日😀";
+  }
+  auto expected = utf8::decode(text);
+
+  // Every split point, including the middle of every sequence
+  for (size_t chunk = 1; chunk <= 5; chunk++) {
+    utf8::StreamDecoder decoder;
+    std::u32string out;
+    for (size_t i = 0; i < text.size(); i += chunk) {
+      auto n = std::min(chunk, text.size() - i);
+      REQUIRE(decoder.feed(text.data() + i, n, out) == ConversionStatus::Ok);
+    }
+    REQUIRE(decoder.finish(out) == ConversionStatus::Ok);
+    REQUIRE(out == expected);
+  }
+
+  utf8::StreamDecoder decoder;
+  std::u32string out;
+  REQUIRE(decoder.feed("a\xF0\x9F", out) == ConversionStatus::Ok);
+  REQUIRE(decoder.pending() == 2);
+  REQUIRE(decoder.feed("\x98", out) == ConversionStatus::Ok);
+  REQUIRE(decoder.pending() == 3);
+  REQUIRE(decoder.feed("\x80" "b", out) == ConversionStatus::Ok);
+  REQUIRE(decoder.pending() == 0);
+  REQUIRE(out == U"a😀b");
+}
+
+TEST_CASE("StreamDecoder error policies", "[utf8]") {
+  // One U+FFFD per maximal subpart: "\xF0\x9F" and "\xE6" are cut short,
+  // "\x80" and "\xC0" cannot start a sequence.
+  {
+    utf8::StreamDecoder decoder(ErrorPolicy::Replace);
+    std::u32string out;
+    REQUIRE(decoder.feed("a\xF0\x9F", out) == ConversionStatus::Ok);
+    REQUIRE(decoder.feed("b\x80\xC0", out) == ConversionStatus::IllFormed);
+    REQUIRE(decoder.feed("c\xE6", out) == ConversionStatus::Ok);
+    REQUIRE(decoder.finish(out) == ConversionStatus::IllFormed);
+    REQUIRE(out == U"a\uFFFDb\uFFFD\uFFFDc\uFFFD");
+  }
+  {
+    utf8::StreamDecoder decoder(ErrorPolicy::Skip);
+    std::u32string out;
+    REQUIRE(decoder.feed("a\xF0\x9F", out) == ConversionStatus::Ok);
+    REQUIRE(decoder.feed("b\x80\xC0", out) == ConversionStatus::IllFormed);
+    REQUIRE(decoder.feed("c\xE6", out) == ConversionStatus::Ok);
+    REQUIRE(decoder.finish(out) == ConversionStatus::IllFormed);
+    REQUIRE(out == U"abc");
+  }
+  {
+    // A surrogate is ill-formed as soon as its second byte arrives.
+    utf8::StreamDecoder decoder(ErrorPolicy::Replace);
+    std::u32string out;
+    REQUIRE(decoder.feed("\xED", out) == ConversionStatus::Ok);
+    REQUIRE(decoder.feed("\xA0\x80", out) == ConversionStatus::IllFormed);
+    REQUIRE(decoder.pending() == 0);
+    REQUIRE(out == U"\uFFFD\uFFFD\uFFFD");
+  }
+}
+
+TEST_CASE("StreamDecoder strict policy", "[utf8]") {
+  utf8::StreamDecoder decoder(ErrorPolicy::Strict);
+  std::u32string out;
+  REQUIRE(decoder.feed("ab\xE6\x97", out) == ConversionStatus::Ok);
+  REQUIRE(decoder.feed("\xA5" "c\xE6", out) == ConversionStatus::Ok);
+  REQUIRE(decoder.feed("d", out) == ConversionStatus::IllFormed);
+  REQUIRE(decoder.consumed() == 6);
+  REQUIRE(decoder.feed("e", out) == ConversionStatus::IllFormed);
+  REQUIRE(decoder.finish(out) == ConversionStatus::IllFormed);
+  REQUIRE(out == U"ab日c");
+
+  // finish() starts a new stream.
+  REQUIRE(decoder.feed("xyz", out) == ConversionStatus::Ok);
+  REQUIRE(decoder.consumed() == 3);
+  REQUIRE(decoder.finish(out) == ConversionStatus::Ok);
+  REQUIRE(out == U"ab日cxyz");
+}
+
+TEST_CASE("codepoint_view", "[utf8]") {
+  std::string text = u8"aé日😀";
+  utf8::codepoint_view view(text);
+
+  std::u32string cps;
+  std::vector<size_t> offsets;
+  for (auto it = view.begin(); it != view.end(); ++it) {
+    cps += *it;
+    offsets.push_back(it.offset());
+  }
+  REQUIRE(cps == U"aé日😀");
+  REQUIRE(offsets == std::vector<size_t>{0, 1, 3, 6});
+
+  auto it = view.end();
+  --it;
+  REQUIRE(*it == U'😀');
+  REQUIRE(it.length() == 4);
+  --it;
+  REQUIRE(*it == U'日');
+  REQUIRE(view.at(3) == it);
+
+  // Ill-formed input keeps its place: one U+FFFD per maximal subpart.
+  std::string bad = "a\xF0\x9F" "b\x80";
+  std::u32string forward(utf8::codepoint_view(bad).begin(),
+                         utf8::codepoint_view(bad).end());
+  REQUIRE(forward == U"a\uFFFDb\uFFFD");
+  utf8::codepoint_view bad_view(bad);
+  it = bad_view.end();
+  REQUIRE((--it).offset() == 4);
+  REQUIRE((--it).offset() == 3);
+  REQUIRE((--it).offset() == 1);
+  REQUIRE(it.length() == 2);
+}
+
+TEST_CASE("codepoint_view with the text algorithms", "[utf8]") {
+  std::string text = u8"Hello 🇯🇵! Ünïcode wörld. Σ";
+  auto s32 = utf8::decode(text);
+  utf8::codepoint_view view(text);
+
+  REQUIRE(grapheme_count(view.begin(), view.end()) ==
+          grapheme_count(s32.data(), s32.size()));
+  REQUIRE(width(view.begin(), view.end()) == width(s32));
+  REQUIRE(to_uppercase(view.begin(), view.end()) ==
+          to_uppercase(s32.data(), s32.size()));
+  REQUIRE(to_titlecase(view.begin(), view.end()) ==
+          to_titlecase(s32.data(), s32.size()));
+  REQUIRE(to_case_fold(view.begin(), view.end()) ==
+          to_case_fold(s32.data(), s32.size()));
+
+  // Word boundaries reported as byte offsets
+  std::vector<size_t> words;
+  for (auto it = view.begin(); it != view.end(); ++it) {
+    if (is_word_boundary(view.begin(), view.end(), it)) {
+      words.push_back(it.offset());
+    }
+  }
+  std::vector<size_t> expected;
+  size_t i = 0;
+  for (auto it = view.begin(); it != view.end(); ++it, ++i) {
+    if (is_word_boundary(s32.data(), s32.size(), i)) {
+      expected.push_back(it.offset());
+    }
+  }
+  REQUIRE(words == expected);
+  REQUIRE(words.front() == 0);
+  REQUIRE(words[1] == 5);  // after "Hello"
+}
+
 }  // namespace test_utf8
 
 //-----------------------------------------------------------------------------
@@ -827,6 +1684,135 @@ TEST_CASE("utf16 codepoint_count with unpaired surrogates", "[utf16]") {
   REQUIRE(utf16::codepoint_count(s, 4) == 2);
 }
 
+TEST_CASE("utf16 encode long text", "[utf16]") {
+  std::u32string bmp(40, U'\u3042');
+  for (auto cp : {U'a', U'\uFFFF', U'\U0001F600', char32_t(0xD800),
+                  char32_t(0xDFFF), char32_t(0x110000)}) {
+    for (size_t pos = 0; pos <= bmp.size(); pos++) {
+      auto s32 = bmp;
+      s32.insert(pos, 1, cp);
+      std::u16string expected;
+      for (auto c : s32) {
+        utf16::encode_codepoint(c, expected);
+      }
+      REQUIRE(utf16::exact_encoded_length(s32.data(), s32.size()) ==
+              expected.size());
+      std::u16string out = u"prefix";
+      utf16::encode(s32, out);
+      REQUIRE(out == u"prefix" + expected);
+    }
+  }
+}
+
+TEST_CASE("utf16 encode and decode into a caller buffer", "[utf16]") {
+  std::u32string s32(40, U'\u3042');
+  s32 += U"a😀";
+  auto s16 = utf16::encode(s32);
+
+  std::u16string out16(s16.size(), u'\0');
+  auto r = utf16::encode(s32.data(), s32.size(), &out16[0], out16.size());
+  REQUIRE(r.status == ConversionStatus::Ok);
+  REQUIRE(out16 == s16);
+
+  // A surrogate pair is never split.
+  r = utf16::encode(s32.data(), s32.size(), &out16[0], out16.size() - 1);
+  REQUIRE(r.status == ConversionStatus::OutputFull);
+  REQUIRE(r.read == s32.size() - 1);
+  REQUIRE(r.written == s16.size() - 2);
+
+  REQUIRE(utf16::max_decoded_length(s16.size()) >= s32.size());
+  std::u32string out32(s32.size(), U'\0');
+  r = utf16::decode(s16.data(), s16.size(), &out32[0], out32.size());
+  REQUIRE(r.status == ConversionStatus::Ok);
+  REQUIRE(r.read == s16.size());
+  REQUIRE(out32 == s32);
+
+  r = utf16::decode(s16.data(), s16.size(), &out32[0], 10);
+  REQUIRE(r.status == ConversionStatus::OutputFull);
+  REQUIRE(r.read == 10);
+  REQUIRE(r.written == 10);
+
+  s16.insert(s16.begin() + 1, char16_t(0xDC00));
+  r = utf16::decode(s16.data(), s16.size(), &out32[0], out32.size());
+  REQUIRE(r.status == ConversionStatus::IllFormed);
+  REQUIRE(out32 == s32);
+}
+
+TEST_CASE("utf16 decode error policies", "[utf16]") {
+  std::u16string text = u"a";
+  text += char16_t(0xD83D);
+  text += u"b";
+  text += char16_t(0xDE00);
+
+  REQUIRE(utf16::decode(text, ErrorPolicy::Skip) == U"ab");
+  REQUIRE(utf16::decode(text, ErrorPolicy::Replace) == U"a\uFFFDb\uFFFD");
+
+  std::u32string out;
+  auto r = utf16::decode(text, out, ErrorPolicy::Strict);
+  REQUIRE(r.status == ConversionStatus::IllFormed);
+  REQUIRE(r.read == 1);
+  REQUIRE(out == U"a");
+
+  std::string out8(text.size() * 3, '\0');
+  r = to_utf8(text.data(), text.size(), &out8[0], out8.size(),
+              ErrorPolicy::Replace);
+  REQUIRE(r.status == ConversionStatus::IllFormed);
+  REQUIRE(out8.substr(0, r.written) == u8"a\uFFFDb\uFFFD");
+}
+
+TEST_CASE("utf16 StreamDecoder", "[utf16]") {
+  std::u16string text(40, u'x');
+  for (int i = 0; i < 10; i++) {
+    text += u"a日😀";
+  }
+  std::u32string expected;
+  utf16::decode(text.data(), text.size(), expected);
+
+  for (size_t chunk = 1; chunk <= 3; chunk++) {
+    utf16::StreamDecoder decoder;
+    std::u32string out;
+    for (size_t i = 0; i < text.size(); i += chunk) {
+      auto n = std::min(chunk, text.size() - i);
+      REQUIRE(decoder.feed(text.data() + i, n, out) == ConversionStatus::Ok);
+    }
+    REQUIRE(decoder.finish(out) == ConversionStatus::Ok);
+    REQUIRE(out == expected);
+  }
+
+  utf16::StreamDecoder decoder(ErrorPolicy::Replace);
+  std::u32string out;
+  std::u16string high(1, char16_t(0xD83D));
+  std::u16string low(1, char16_t(0xDE00));
+  REQUIRE(decoder.feed(u"a" + high, out) == ConversionStatus::Ok);
+  REQUIRE(decoder.pending() == 1);
+  REQUIRE(decoder.feed(low + high, out) == ConversionStatus::Ok);
+  REQUIRE(decoder.feed(u"b" + high, out) == ConversionStatus::IllFormed);
+  REQUIRE(decoder.finish(out) == ConversionStatus::IllFormed);
+  REQUIRE(out == U"a😀\uFFFDb\uFFFD");
+}
+
+TEST_CASE("utf16 codepoint_view", "[utf16]") {
+  std::u16string text = u"a😀";
+  text += char16_t(0xDC00);
+  text += u"b";
+  utf16::codepoint_view view(text);
+
+  std::u32string forward(view.begin(), view.end());
+  REQUIRE(forward == U"a😀\uFFFDb");
+
+  std::u32string backward;
+  for (auto it = view.end(); it != view.begin();) {
+    --it;
+    backward += *it;
+  }
+  REQUIRE(backward == U"b\uFFFD😀a");
+
+  auto it = std::next(view.begin());
+  REQUIRE(it.offset() == 1);
+  REQUIRE(it.length() == 2);
+  REQUIRE(std::next(it).offset() == 3);
+}
+
 }  // namespace test_utf16
 
 //-----------------------------------------------------------------------------
@@ -852,6 +1838,59 @@ TEST_CASE("Conversion text", "[encodings]") {
   REQUIRE(to_utf32(wtext) == u32text);
 }
 
+TEST_CASE("Conversion of long text", "[encodings]") {
+  // Long ASCII runs for the SIMD kernels, followed by text that is not
+  std::string u8text(100, 'x');
+  std::u16string u16text(100, u'x');
+  std::u32string u32text(100, U'x');
+  for (int i = 0; i < 10; i++) {
+    u8text += u8"日本語 héllo 😀 ";
+    u16text += u"日本語 héllo 😀 ";
+    u32text += U"日本語 héllo 😀 ";
+  }
+  std::wstring wtext(u32text.begin(), u32text.end());
+  if constexpr (sizeof(wchar_t) == 2) {
+    wtext.assign(u16text.begin(), u16text.end());
+  }
+
+  REQUIRE(to_utf16(u8text) == u16text);
+  REQUIRE(to_utf8(u16text) == u8text);
+  REQUIRE(to_wstring(u8text) == wtext);
+  REQUIRE(to_wstring(u16text) == wtext);
+  REQUIRE(to_wstring(u32text) == wtext);
+  REQUIRE(to_utf8(wtext) == u8text);
+  REQUIRE(to_utf16(wtext) == u16text);
+  REQUIRE(to_utf32(wtext) == u32text);
+
+  // Ill-formed input is dropped, as utf8::decode and utf16::decode do.
+  REQUIRE(to_utf16(u8text + "\xED\xA0\x80" + u8text) == u16text + u16text);
+  std::u16string unpaired(1, char16_t(0xD800));
+  REQUIRE(to_utf8(u16text + unpaired + u16text) == u8text + u8text);
+  REQUIRE(to_wstring(u16text + unpaired + u16text) == wtext + wtext);
+}
+
+TEST_CASE("Conversion into a caller buffer", "[encodings]") {
+  std::string u8text(100, 'x');
+  u8text += u8"日本語 héllo 😀";
+  auto u16text = to_utf16(u8text);
+
+  std::u16string out16(u8text.size(), u'\0');
+  auto r = to_utf16(u8text.data(), u8text.size(), &out16[0], out16.size());
+  REQUIRE(r.status == ConversionStatus::Ok);
+  REQUIRE(out16.substr(0, r.written) == u16text);
+
+  std::string out8(u16text.size() * 3, '\0');
+  r = to_utf8(u16text.data(), u16text.size(), &out8[0], out8.size());
+  REQUIRE(r.status == ConversionStatus::Ok);
+  REQUIRE(out8.substr(0, r.written) == u8text);
+
+  // The output fills up before the emoji.
+  r = to_utf8(u16text.data(), u16text.size(), &out8[0], u8text.size() - 1);
+  REQUIRE(r.status == ConversionStatus::OutputFull);
+  REQUIRE(r.read == u16text.size() - 2);
+  REQUIRE(r.written == u8text.size() - 4);
+}
+
 }  // namespace test_encodeings
 
 //-----------------------------------------------------------------------------
@@ -9,12 +9,23 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <iterator>
 #include <string>
 
 #if !defined(__cplusplus) || __cplusplus < 201703L
 #error "Requires complete C++17 support"
 #endif
 
+// SIMD kernels are compiled with per-function target attributes and picked at
+// run time, so no -mavx2 is needed. Define UNICODELIB_NO_SIMD to use only the
+// portable code.
+#if !defined(UNICODELIB_NO_SIMD) && \
+    (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define UNICODELIB_X86_64_SIMD
+#include <immintrin.h>
+#endif
+
 /*
 
   namespace utf8 {
@@ -24,10 +35,34 @@
     size_t codepoint_count(const char *s8, size_t l);
 
     size_t encode_codepoint(char32_t cp, std::string &out);
+    size_t exact_encoded_length(const char32_t *s32, size_t l);
     void encode(const char32_t *s32, size_t l, std::string &out);
+    ConversionResult encode(const char32_t *s32, size_t l, char *out,
+                            size_t cap);
 
     size_t decode_codepoint(const char *s8, size_t l, char32_t &out);
     void decode(const char *s8, size_t l, std::u32string &out);
+    ConversionResult decode(const char *s8, size_t l, std::u32string &out,
+                            ErrorPolicy policy);
+    size_t max_decoded_length(size_t l);
+    ConversionResult decode(const char *s8, size_t l, char32_t *out,
+                            size_t cap, ErrorPolicy policy = Skip);
+
+    size_t validate(const char *s8, size_t l);
+
+    class StreamDecoder {
+      StreamDecoder(ErrorPolicy policy = ErrorPolicy::Skip);
+      ConversionStatus feed(const char *s8, size_t l, std::u32string &out);
+      ConversionStatus finish(std::u32string &out);
+      size_t consumed() const;
+    };
+
+    class codepoint_view {
+      codepoint_view(const char *s8, size_t l);
+      iterator begin() const;  // bidirectional; offset() is in bytes
+      iterator end() const;
+      iterator at(size_t i) const;
+    };
 
   }  // namespace utf8
 
@@ -38,16 +73,44 @@
     size_t codepoint_count(const char16_t *s16, size_t l);
 
     size_t encode_codepoint(char32_t cp, std::u16string &out);
+    size_t exact_encoded_length(const char32_t *s32, size_t l);
     void encode(const char32_t *s32, size_t l, std::u16string &out);
+    ConversionResult encode(const char32_t *s32, size_t l, char16_t *out,
+                            size_t cap);
 
     size_t decode_codepoint(const char16_t *s16, size_t l, char32_t &out);
     void decode(const char16_t *s16, size_t l, std::u32string &out);
+    ConversionResult decode(const char16_t *s16, size_t l,
+                            std::u32string &out, ErrorPolicy policy);
+    size_t max_decoded_length(size_t l);
+    ConversionResult decode(const char16_t *s16, size_t l, char32_t *out,
+                            size_t cap, ErrorPolicy policy = Skip);
+
+    class StreamDecoder {
+      StreamDecoder(ErrorPolicy policy = ErrorPolicy::Skip);
+      ConversionStatus feed(const char16_t *s16, size_t l,
+                            std::u32string &out);
+      ConversionStatus finish(std::u32string &out);
+      size_t consumed() const;
+    };
+
+    class codepoint_view {
+      codepoint_view(const char16_t *s16, size_t l);
+      iterator begin() const;  // bidirectional; offset() is in code units
+      iterator end() const;
+      iterator at(size_t i) const;
+    };
 
   }  // namespace utf16
 
   std::string to_utf8(const char16_t *s16, size_t l);
   std::u16string to_utf16(const char *s8, size_t l);
 
+  ConversionResult to_utf8(const char16_t *s16, size_t l, char *out,
+                           size_t cap, ErrorPolicy policy = Skip);
+  ConversionResult to_utf16(const char *s8, size_t l, char16_t *out,
+                            size_t cap, ErrorPolicy policy = Skip);
+
   std::wstring to_wstring(const char *s8, size_t l);
   std::wstring to_wstring(const char16_t *s16, size_t l);
   std::wstring to_wstring(const char32_t *s32, size_t l);
@@ -60,6 +123,723 @@
 
 namespace unicode {
 
+//-----------------------------------------------------------------------------
+// Conversion result
+//-----------------------------------------------------------------------------
+
+enum class ConversionStatus {
+  Ok,          // all input was converted
+  IllFormed,   // ill-formed input was dropped or replaced, or stopped at it
+  OutputFull,  // stopped because the next code point did not fit
+};
+
+// What decoding does with ill-formed input
+enum class ErrorPolicy {
+  Skip,     // drop it
+  Replace,  // substitute U+FFFD for each maximal subpart (Unicode 3.9)
+  Strict,   // stop at it
+};
+
+// Returned by the conversions into a caller-provided buffer. `read` is where
+// to resume when the status is OutputFull, and where the ill-formed input
+// starts when it is IllFormed under ErrorPolicy::Strict.
+struct ConversionResult {
+  size_t read = 0;     // input code units consumed
+  size_t written = 0;  // output code units written
+  ConversionStatus status = ConversionStatus::Ok;
+};
+
+//-----------------------------------------------------------------------------
+// SIMD kernels
+//-----------------------------------------------------------------------------
+
+namespace detail {
+
+enum class SimdLevel { None, SSE41, AVX2 };
+
+inline SimdLevel simd_level() {
+#ifdef UNICODELIB_X86_64_SIMD
+  static const auto level = [] {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+      return SimdLevel::SSE41;
+    }
+    return SimdLevel::None;
+  }();
+  return level;
+#else
+  return SimdLevel::None;
+#endif
+}
+
+// Decodes the complete sequences in `s8`, which must be well-formed apart
+// from a sequence cut off at the end, into UTF-16 when T is 16 bits wide and
+// into UTF-32 otherwise. Returns the bytes consumed.
+template <typename T>
+inline size_t utf8_decode_valid(const char *s8, size_t l, T *out,
+                                size_t &written) {
+  size_t i = 0;
+  while (i < l) {
+    auto b = static_cast<uint8_t>(s8[i]);
+    if (b < 0x80) {
+      out[written++] = static_cast<T>(b);
+      i++;
+    } else if (b < 0xE0) {
+      if (i + 2 > l) {
+        break;
+      }
+      out[written++] = static_cast<T>(((b & 0x1F) << 6) | (s8[i + 1] & 0x3F));
+      i += 2;
+    } else if (b < 0xF0) {
+      if (i + 3 > l) {
+        break;
+      }
+      out[written++] = static_cast<T>(((b & 0x0F) << 12) |
+                                      ((s8[i + 1] & 0x3F) << 6) |
+                                      (s8[i + 2] & 0x3F));
+      i += 3;
+    } else {
+      if (i + 4 > l) {
+        break;
+      }
+      auto cp = (static_cast<char32_t>(b & 0x07) << 18) |
+                (static_cast<char32_t>(s8[i + 1] & 0x3F) << 12) |
+                (static_cast<char32_t>(s8[i + 2] & 0x3F) << 6) |
+                (static_cast<char32_t>(s8[i + 3] & 0x3F));
+      if constexpr (sizeof(T) == 2) {
+        out[written++] = static_cast<T>(0xD800 + ((cp - 0x10000) >> 10));
+        out[written++] = static_cast<T>(0xDC00 + ((cp - 0x10000) & 0x3FF));
+      } else {
+        out[written++] = static_cast<T>(cp);
+      }
+      i += 4;
+    }
+  }
+  return i;
+}
+
+template <typename T>
+inline bool utf16_decode_codepoint(const T *s16, size_t l, size_t &length,
+                                   char32_t &cp) {
+  if (l) {
+    // Surrogate
+    char32_t first = s16[0];
+    if (0xD800 <= first && first < 0xDC00) {
+      if (l >= 2) {
+        char32_t second = s16[1];
+        if (0xDC00 <= second && second < 0xE000) {
+          cp = (((first - 0xD800) << 10) | (second - 0xDC00)) + 0x10000;
+          length = 2;
+          return true;
+        }
+      }
+    }
+
+    // Non surrogate
+    else if (first < 0xD800 || first >= 0xE000) {
+      cp = first;
+      length = 1;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Single-pass converters between the encodings, defined after the utf8 and
+// utf16 namespaces. A 16-bit T means UTF-16 and a 32-bit T UTF-32, so that
+// wchar_t strings go through the same code. The string overloads append to
+// `out`.
+template <typename T>
+ConversionResult utf8_to_units(const char *s8, size_t l, T *out, size_t cap,
+                               ErrorPolicy policy = ErrorPolicy::Skip);
+template <typename T>
+ConversionResult utf8_to_units(const char *s8, size_t l,
+                               std::basic_string<T> &out,
+                               ErrorPolicy policy = ErrorPolicy::Skip);
+
+template <typename T>
+ConversionResult utf16_to_utf8(const T *s16, size_t l, char *out, size_t cap,
+                               ErrorPolicy policy = ErrorPolicy::Skip);
+template <typename T>
+ConversionResult utf16_to_utf8(const T *s16, size_t l, std::string &out,
+                               ErrorPolicy policy = ErrorPolicy::Skip);
+
+template <typename T, typename U>
+ConversionResult utf16_to_utf32(const T *s16, size_t l, U *out, size_t cap,
+                                ErrorPolicy policy = ErrorPolicy::Skip);
+template <typename T, typename U>
+ConversionResult utf16_to_utf32(const T *s16, size_t l,
+                                std::basic_string<U> &out,
+                                ErrorPolicy policy = ErrorPolicy::Skip);
+
+template <typename T>
+size_t utf32_encoded_length(const T *s32, size_t l, bool to_utf16);
+
+template <typename T, typename U>
+ConversionResult utf32_to_units(const T *s32, size_t l, U *out, size_t cap);
+template <typename T, typename U>
+void utf32_to_units(const T *s32, size_t l, std::basic_string<U> &out);
+
+#ifdef UNICODELIB_X86_64_SIMD
+
+// UTF-8 validation by Keiser and Lemire, "Validating UTF-8 In Less Than One
+// Instruction Per Byte". Each byte is classified by the high nibble of the
+// previous byte, the low nibble of the previous byte and its own high nibble;
+// the AND of the three lookups is non-zero only for an ill-formed pair. The
+// 3rd and 4th bytes of longer sequences are checked against prev2/prev3.
+
+constexpr uint8_t UTF8_TOO_SHORT = 1 << 0;       // 11______ 0_______
+                                                 // 11______ 11______
+constexpr uint8_t UTF8_TOO_LONG = 1 << 1;        // 0_______ 10______
+constexpr uint8_t UTF8_OVERLONG_3 = 1 << 2;      // 11100000 100_____
+constexpr uint8_t UTF8_TOO_LARGE = 1 << 3;       // 11110100 1001____ ...
+constexpr uint8_t UTF8_SURROGATE = 1 << 4;       // 11101101 101_____
+constexpr uint8_t UTF8_OVERLONG_2 = 1 << 5;      // 1100000_ 10______
+constexpr uint8_t UTF8_TOO_LARGE_1000 = 1 << 6;  // 11110101 1000____ ...
+constexpr uint8_t UTF8_OVERLONG_4 = 1 << 6;      // 11110000 1000____
+constexpr uint8_t UTF8_TWO_CONTS = 1 << 7;       // 10______ 10______
+constexpr uint8_t UTF8_CARRY =
+    UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS;
+
+constexpr uint8_t utf8_byte_1_high[16] = {
+    // 0_______ ________
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    // 10______ ________
+    UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+    // 1100____ ________
+    UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+    // 1101____ ________
+    UTF8_TOO_SHORT,
+    // 1110____ ________
+    UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+    // 1111____ ________
+    UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4};
+
+constexpr uint8_t utf8_byte_1_low[16] = {
+    // ____0000 ________
+    UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+    // ____0001 ________
+    UTF8_CARRY | UTF8_OVERLONG_2,
+    // ____001_ ________
+    UTF8_CARRY, UTF8_CARRY,
+    // ____0100 ________
+    UTF8_CARRY | UTF8_TOO_LARGE,
+    // ____0101 ________ to ____1100 ________
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    // ____1101 ________
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+    // ____111_ ________
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+    UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000};
+
+constexpr uint8_t utf8_byte_2_high[16] = {
+    // ________ 0_______
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    // ________ 1000____
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 |
+        UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+    // ________ 1001____
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 |
+        UTF8_TOO_LARGE,
+    // ________ 101_____
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE |
+        UTF8_TOO_LARGE,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE |
+        UTF8_TOO_LARGE,
+    // ________ 11______
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT};
+
+__attribute__((target("sse4.1"))) inline __m128i
+utf8_errors_sse41(__m128i input, __m128i prev_input) {
+  const auto table_1_high =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(utf8_byte_1_high));
+  const auto table_1_low =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(utf8_byte_1_low));
+  const auto table_2_high =
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(utf8_byte_2_high));
+  const auto nibble = _mm_set1_epi8(0x0F);
+
+  auto prev1 = _mm_alignr_epi8(input, prev_input, 15);
+  auto byte_1_high = _mm_shuffle_epi8(
+      table_1_high, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+  auto byte_1_low =
+      _mm_shuffle_epi8(table_1_low, _mm_and_si128(prev1, nibble));
+  auto byte_2_high = _mm_shuffle_epi8(
+      table_2_high, _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+  auto special_cases =
+      _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+  // Bytes that must be the 3rd or 4th byte of a sequence have the high bit
+  // set here; it cancels the TWO_CONTS bit of special_cases.
+  auto prev2 = _mm_alignr_epi8(input, prev_input, 14);
+  auto prev3 = _mm_alignr_epi8(input, prev_input, 13);
+  auto is_third_byte = _mm_subs_epu8(prev2, _mm_set1_epi8(0xE0 - 0x80));
+  auto is_fourth_byte =
+      _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+  auto must_be_continuation = _mm_and_si128(
+      _mm_or_si128(is_third_byte, is_fourth_byte), _mm_set1_epi8(-0x80));
+  return _mm_xor_si128(must_be_continuation, special_cases);
+}
+
+// Returns the offset of the first 16-byte block in which an error shows up,
+// or where the blocks end. Sequences that cross the returned offset are not
+// checked yet.
+__attribute__((target("sse4.1"))) inline size_t
+utf8_validate_sse41(const char *s8, size_t l) {
+  auto prev_input = _mm_setzero_si128();
+  // The last 1, 2 or 3 bytes of a block may not start a sequence that is
+  // longer than what is left of the block.
+  const auto max_tail =
+      _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                    static_cast<char>(0xEF), static_cast<char>(0xDF),
+                    static_cast<char>(0xBF));
+  size_t i = 0;
+  for (; i + 16 <= l; i += 16) {
+    auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s8 + i));
+    if (_mm_movemask_epi8(input) == 0) {
+      auto incomplete = _mm_subs_epu8(prev_input, max_tail);
+      if (!_mm_testz_si128(incomplete, incomplete)) {
+        break;
+      }
+    } else {
+      auto errors = utf8_errors_sse41(input, prev_input);
+      if (!_mm_testz_si128(errors, errors)) {
+        break;
+      }
+    }
+    prev_input = input;
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) inline __m256i
+utf8_errors_avx2(__m256i input, __m256i prev_input) {
+  const auto table_1_high = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(utf8_byte_1_high)));
+  const auto table_1_low = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(utf8_byte_1_low)));
+  const auto table_2_high = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(utf8_byte_2_high)));
+  const auto nibble = _mm256_set1_epi8(0x0F);
+
+  // The previous bytes of each lane, borrowing from the lane before it.
+  auto shifted = _mm256_permute2x128_si256(prev_input, input, 0x21);
+  auto prev1 = _mm256_alignr_epi8(input, shifted, 15);
+  auto byte_1_high = _mm256_shuffle_epi8(
+      table_1_high, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+  auto byte_1_low =
+      _mm256_shuffle_epi8(table_1_low, _mm256_and_si256(prev1, nibble));
+  auto byte_2_high = _mm256_shuffle_epi8(
+      table_2_high, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+  auto special_cases = _mm256_and_si256(
+      _mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+  auto prev2 = _mm256_alignr_epi8(input, shifted, 14);
+  auto prev3 = _mm256_alignr_epi8(input, shifted, 13);
+  auto is_third_byte = _mm256_subs_epu8(prev2, _mm256_set1_epi8(0xE0 - 0x80));
+  auto is_fourth_byte = _mm256_subs_epu8(
+      prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+  auto must_be_continuation =
+      _mm256_and_si256(_mm256_or_si256(is_third_byte, is_fourth_byte),
+                       _mm256_set1_epi8(-0x80));
+  return _mm256_xor_si256(must_be_continuation, special_cases);
+}
+
+__attribute__((target("avx2"))) inline size_t
+utf8_validate_avx2(const char *s8, size_t l) {
+  auto prev_input = _mm256_setzero_si256();
+  const auto max_tail = _mm256_setr_epi8(
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, static_cast<char>(0xEF),
+      static_cast<char>(0xDF), static_cast<char>(0xBF));
+  size_t i = 0;
+  for (; i + 32 <= l; i += 32) {
+    auto input =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s8 + i));
+    if (_mm256_movemask_epi8(input) == 0) {
+      auto incomplete = _mm256_subs_epu8(prev_input, max_tail);
+      if (!_mm256_testz_si256(incomplete, incomplete)) {
+        break;
+      }
+    } else {
+      auto errors = utf8_errors_avx2(input, prev_input);
+      if (!_mm256_testz_si256(errors, errors)) {
+        break;
+      }
+    }
+    prev_input = input;
+  }
+  return i;
+}
+
+// Decodes 16-byte blocks starting at a code point boundary, ASCII blocks by
+// widening them and well-formed blocks with utf8_decode_valid. Returns the
+// bytes consumed; it stops at a block with an ill-formed sequence, or where
+// fewer than 16 bytes are left.
+template <typename T>
+__attribute__((target("sse4.1"))) inline size_t
+utf8_decode_sse41(const char *s8, size_t l, T *out, size_t &written) {
+  size_t i = 0;
+  while (i + 16 <= l) {
+    auto input = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s8 + i));
+    if (_mm_movemask_epi8(input) == 0) {
+      auto dst = reinterpret_cast<__m128i *>(out + written);
+      if constexpr (sizeof(T) == 2) {
+        _mm_storeu_si128(dst, _mm_cvtepu8_epi16(input));
+        _mm_storeu_si128(dst + 1, _mm_cvtepu8_epi16(_mm_srli_si128(input, 8)));
+      } else {
+        _mm_storeu_si128(dst, _mm_cvtepu8_epi32(input));
+        _mm_storeu_si128(dst + 1,
+                         _mm_cvtepu8_epi32(_mm_srli_si128(input, 4)));
+        _mm_storeu_si128(dst + 2,
+                         _mm_cvtepu8_epi32(_mm_srli_si128(input, 8)));
+        _mm_storeu_si128(dst + 3,
+                         _mm_cvtepu8_epi32(_mm_srli_si128(input, 12)));
+      }
+      written += 16;
+      i += 16;
+      continue;
+    }
+    // A block that starts at a boundary has no context from the bytes before.
+    auto errors = utf8_errors_sse41(input, _mm_setzero_si128());
+    if (!_mm_testz_si128(errors, errors)) {
+      break;
+    }
+    i += utf8_decode_valid(s8 + i, 16, out, written);
+  }
+  return i;
+}
+
+template <typename T>
+__attribute__((target("avx2"))) inline size_t
+utf8_decode_avx2(const char *s8, size_t l, T *out, size_t &written) {
+  size_t i = 0;
+  while (i + 32 <= l) {
+    auto input =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s8 + i));
+    if (_mm256_movemask_epi8(input) == 0) {
+      auto lo = _mm256_castsi256_si128(input);
+      auto hi = _mm256_extracti128_si256(input, 1);
+      auto dst = reinterpret_cast<__m256i *>(out + written);
+      if constexpr (sizeof(T) == 2) {
+        _mm256_storeu_si256(dst, _mm256_cvtepu8_epi16(lo));
+        _mm256_storeu_si256(dst + 1, _mm256_cvtepu8_epi16(hi));
+      } else {
+        _mm256_storeu_si256(dst, _mm256_cvtepu8_epi32(lo));
+        _mm256_storeu_si256(dst + 1,
+                            _mm256_cvtepu8_epi32(_mm_srli_si128(lo, 8)));
+        _mm256_storeu_si256(dst + 2, _mm256_cvtepu8_epi32(hi));
+        _mm256_storeu_si256(dst + 3,
+                            _mm256_cvtepu8_epi32(_mm_srli_si128(hi, 8)));
+      }
+      written += 32;
+      i += 32;
+      continue;
+    }
+    auto errors = utf8_errors_avx2(input, _mm256_setzero_si256());
+    if (!_mm256_testz_si256(errors, errors)) {
+      break;
+    }
+    i += utf8_decode_valid(s8 + i, 32, out, written);
+  }
+  return i;
+}
+
+// Exact UTF-8 or UTF-16 length of UTF-32 text, 8 code points at a time.
+// Surrogates and values beyond U+10FFFF count as 0 since encode_codepoint
+// drops them. Only `l / 8 * 8` code points are counted.
+__attribute__((target("sse4.1"))) inline __m128i
+utf32_unit_counts_sse41(__m128i v, bool to_utf16) {
+  auto too_large =
+      _mm_cmpeq_epi32(_mm_max_epu32(v, _mm_set1_epi32(0x110000)), v);
+  auto offset = _mm_sub_epi32(v, _mm_set1_epi32(0xD800));
+  auto surrogate =
+      _mm_cmpeq_epi32(_mm_min_epu32(offset, _mm_set1_epi32(0x7FF)), offset);
+  // 1 plus one for each threshold passed; the compares give -1 for true.
+  auto counts = _mm_sub_epi32(_mm_set1_epi32(1),
+                              _mm_cmpgt_epi32(v, _mm_set1_epi32(0xFFFF)));
+  if (!to_utf16) {
+    counts = _mm_sub_epi32(counts, _mm_cmpgt_epi32(v, _mm_set1_epi32(0x7F)));
+    counts = _mm_sub_epi32(counts, _mm_cmpgt_epi32(v, _mm_set1_epi32(0x7FF)));
+  }
+  return _mm_andnot_si128(_mm_or_si128(too_large, surrogate), counts);
+}
+
+__attribute__((target("sse4.1"))) inline size_t
+utf32_encoded_length_sse41(const char32_t *s32, size_t l,
+                           bool to_utf16) {
+  size_t total = 0;
+  size_t i = 0;
+  while (i + 8 <= l) {
+    // Lanes grow by at most 8 per round, so flush them now and then.
+    auto end = l - i < (1u << 24) ? l : i + (1u << 24);
+    auto sums = _mm_setzero_si128();
+    for (; i + 8 <= end; i += 8) {
+      auto p = reinterpret_cast<const __m128i *>(s32 + i);
+      auto v0 = _mm_loadu_si128(p);
+      auto v1 = _mm_loadu_si128(p + 1);
+      sums = _mm_add_epi32(sums, utf32_unit_counts_sse41(v0, to_utf16));
+      sums = _mm_add_epi32(sums, utf32_unit_counts_sse41(v1, to_utf16));
+    }
+    uint32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), sums);
+    total += size_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+  }
+  return total;
+}
+
+__attribute__((target("avx2"))) inline __m256i
+utf32_unit_counts_avx2(__m256i v, bool to_utf16) {
+  auto too_large = _mm256_cmpeq_epi32(
+      _mm256_max_epu32(v, _mm256_set1_epi32(0x110000)), v);
+  auto offset = _mm256_sub_epi32(v, _mm256_set1_epi32(0xD800));
+  auto surrogate = _mm256_cmpeq_epi32(
+      _mm256_min_epu32(offset, _mm256_set1_epi32(0x7FF)), offset);
+  auto counts = _mm256_sub_epi32(
+      _mm256_set1_epi32(1), _mm256_cmpgt_epi32(v, _mm256_set1_epi32(0xFFFF)));
+  if (!to_utf16) {
+    counts = _mm256_sub_epi32(counts,
+                              _mm256_cmpgt_epi32(v, _mm256_set1_epi32(0x7F)));
+    counts = _mm256_sub_epi32(counts,
+                              _mm256_cmpgt_epi32(v, _mm256_set1_epi32(0x7FF)));
+  }
+  return _mm256_andnot_si256(_mm256_or_si256(too_large, surrogate), counts);
+}
+
+__attribute__((target("avx2"))) inline size_t
+utf32_encoded_length_avx2(const char32_t *s32, size_t l,
+                          bool to_utf16) {
+  size_t total = 0;
+  size_t i = 0;
+  while (i + 8 <= l) {
+    auto end = l - i < (1u << 24) ? l : i + (1u << 24);
+    auto sums = _mm256_setzero_si256();
+    for (; i + 8 <= end; i += 8) {
+      auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s32 + i));
+      sums = _mm256_add_epi32(sums, utf32_unit_counts_avx2(v, to_utf16));
+    }
+    uint32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), sums);
+    for (auto n : lanes) {
+      total += n;
+    }
+  }
+  return total;
+}
+
+// Encodes blocks of 8 code points that are all ASCII (UTF-8) or all BMP
+// non-surrogates (UTF-16) by narrowing them. Returns the code points
+// consumed; it stops at the first block that needs the scalar encoder.
+__attribute__((target("sse4.1"))) inline size_t
+utf8_encode_sse41(const char32_t *s32, size_t l, char *out, size_t &written) {
+  const auto non_ascii = _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+  size_t i = 0;
+  for (; i + 8 <= l; i += 8) {
+    auto p = reinterpret_cast<const __m128i *>(s32 + i);
+    auto v0 = _mm_loadu_si128(p);
+    auto v1 = _mm_loadu_si128(p + 1);
+    if (!_mm_testz_si128(_mm_or_si128(v0, v1), non_ascii)) {
+      break;
+    }
+    auto words = _mm_packus_epi32(v0, v1);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(out + written),
+                     _mm_packus_epi16(words, words));
+    written += 8;
+  }
+  return i;
+}
+
+__attribute__((target("sse4.1"))) inline bool
+utf16_is_single_unit_sse41(__m128i v) {
+  auto offset = _mm_sub_epi32(v, _mm_set1_epi32(0xD800));
+  auto surrogate =
+      _mm_cmpeq_epi32(_mm_min_epu32(offset, _mm_set1_epi32(0x7FF)), offset);
+  return _mm_testz_si128(v, _mm_set1_epi32(static_cast<int>(0xFFFF0000))) &&
+         _mm_testz_si128(surrogate, surrogate);
+}
+
+__attribute__((target("sse4.1"))) inline size_t
+utf16_encode_sse41(const char32_t *s32, size_t l, char16_t *out,
+                   size_t &written) {
+  size_t i = 0;
+  for (; i + 8 <= l; i += 8) {
+    auto p = reinterpret_cast<const __m128i *>(s32 + i);
+    auto v0 = _mm_loadu_si128(p);
+    auto v1 = _mm_loadu_si128(p + 1);
+    if (!utf16_is_single_unit_sse41(v0) || !utf16_is_single_unit_sse41(v1)) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + written),
+                     _mm_packus_epi32(v0, v1));
+    written += 8;
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) inline size_t
+utf8_encode_avx2(const char32_t *s32, size_t l, char *out, size_t &written) {
+  const auto non_ascii = _mm256_set1_epi32(static_cast<int>(0xFFFFFF80));
+  size_t i = 0;
+  for (; i + 16 <= l; i += 16) {
+    auto p = reinterpret_cast<const __m256i *>(s32 + i);
+    auto v0 = _mm256_loadu_si256(p);
+    auto v1 = _mm256_loadu_si256(p + 1);
+    if (!_mm256_testz_si256(_mm256_or_si256(v0, v1), non_ascii)) {
+      break;
+    }
+    // packus works within 128-bit lanes; restore the order afterwards.
+    auto words = _mm256_permute4x64_epi64(_mm256_packus_epi32(v0, v1), 0xD8);
+    auto bytes = _mm_packus_epi16(_mm256_castsi256_si128(words),
+                                  _mm256_extracti128_si256(words, 1));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + written), bytes);
+    written += 16;
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) inline size_t
+utf16_encode_avx2(const char32_t *s32, size_t l, char16_t *out,
+                  size_t &written) {
+  size_t i = 0;
+  for (; i + 16 <= l; i += 16) {
+    auto p = reinterpret_cast<const __m256i *>(s32 + i);
+    auto v0 = _mm256_loadu_si256(p);
+    auto v1 = _mm256_loadu_si256(p + 1);
+    auto v = _mm256_or_si256(v0, v1);
+    auto offset0 = _mm256_sub_epi32(v0, _mm256_set1_epi32(0xD800));
+    auto offset1 = _mm256_sub_epi32(v1, _mm256_set1_epi32(0xD800));
+    auto surrogate = _mm256_or_si256(
+        _mm256_cmpeq_epi32(
+            _mm256_min_epu32(offset0, _mm256_set1_epi32(0x7FF)), offset0),
+        _mm256_cmpeq_epi32(
+            _mm256_min_epu32(offset1, _mm256_set1_epi32(0x7FF)), offset1));
+    if (!_mm256_testz_si256(
+            v, _mm256_set1_epi32(static_cast<int>(0xFFFF0000))) ||
+        !_mm256_testz_si256(surrogate, surrogate)) {
+      break;
+    }
+    auto words = _mm256_permute4x64_epi64(_mm256_packus_epi32(v0, v1), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + written), words);
+    written += 16;
+  }
+  return i;
+}
+
+// Widens blocks of UTF-16 without surrogates to UTF-32. Returns the units
+// consumed; it stops at the first block with a surrogate.
+__attribute__((target("sse4.1"))) inline size_t
+utf16_decode_sse41(const char16_t *s16, size_t l, char32_t *out,
+                   size_t &written) {
+  const auto mask = _mm_set1_epi16(static_cast<short>(0xF800));
+  const auto surrogate = _mm_set1_epi16(static_cast<short>(0xD800));
+  size_t i = 0;
+  for (; i + 8 <= l; i += 8) {
+    auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s16 + i));
+    auto found = _mm_cmpeq_epi16(_mm_and_si128(v, mask), surrogate);
+    if (!_mm_testz_si128(found, found)) {
+      break;
+    }
+    auto dst = reinterpret_cast<__m128i *>(out + written);
+    _mm_storeu_si128(dst, _mm_cvtepu16_epi32(v));
+    _mm_storeu_si128(dst + 1, _mm_cvtepu16_epi32(_mm_srli_si128(v, 8)));
+    written += 8;
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) inline size_t
+utf16_decode_avx2(const char16_t *s16, size_t l, char32_t *out,
+                  size_t &written) {
+  const auto mask = _mm256_set1_epi16(static_cast<short>(0xF800));
+  const auto surrogate = _mm256_set1_epi16(static_cast<short>(0xD800));
+  size_t i = 0;
+  for (; i + 16 <= l; i += 16) {
+    auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s16 + i));
+    auto found = _mm256_cmpeq_epi16(_mm256_and_si256(v, mask), surrogate);
+    if (!_mm256_testz_si256(found, found)) {
+      break;
+    }
+    auto lo = _mm256_castsi256_si128(v);
+    auto hi = _mm256_extracti128_si256(v, 1);
+    auto dst = reinterpret_cast<__m256i *>(out + written);
+    _mm256_storeu_si256(dst, _mm256_cvtepu16_epi32(lo));
+    _mm256_storeu_si256(dst + 1, _mm256_cvtepu16_epi32(hi));
+    written += 16;
+  }
+  return i;
+}
+
+// Narrows blocks of ASCII UTF-16 to UTF-8. Returns the units consumed; it
+// stops at the first block with a non-ASCII unit.
+__attribute__((target("sse4.1"))) inline size_t
+utf16_to_utf8_sse41(const char16_t *s16, size_t l, char *out,
+                    size_t &written) {
+  const auto non_ascii = _mm_set1_epi16(static_cast<short>(0xFF80));
+  size_t i = 0;
+  for (; i + 16 <= l; i += 16) {
+    auto p = reinterpret_cast<const __m128i *>(s16 + i);
+    auto v0 = _mm_loadu_si128(p);
+    auto v1 = _mm_loadu_si128(p + 1);
+    if (!_mm_testz_si128(_mm_or_si128(v0, v1), non_ascii)) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + written),
+                     _mm_packus_epi16(v0, v1));
+    written += 16;
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) inline size_t
+utf16_to_utf8_avx2(const char16_t *s16, size_t l, char *out,
+                   size_t &written) {
+  const auto non_ascii = _mm256_set1_epi16(static_cast<short>(0xFF80));
+  size_t i = 0;
+  for (; i + 32 <= l; i += 32) {
+    auto p = reinterpret_cast<const __m256i *>(s16 + i);
+    auto v0 = _mm256_loadu_si256(p);
+    auto v1 = _mm256_loadu_si256(p + 1);
+    if (!_mm256_testz_si256(_mm256_or_si256(v0, v1), non_ascii)) {
+      break;
+    }
+    auto bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(v0, v1), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + written), bytes);
+    written += 32;
+  }
+  return i;
+}
+
+#endif
+
+// Everything before `i` is known to be well-formed, except for a sequence that
+// may cross `i`. Returns where that sequence starts, or `i`.
+inline size_t utf8_sequence_start(const char *s8, size_t i) {
+  auto p = i;
+  while (p > 0 && i - p < 3 &&
+         (static_cast<uint8_t>(s8[p - 1]) & 0xC0) == 0x80) {
+    p--;
+  }
+  if (p > 0 && i - p < 3 && static_cast<uint8_t>(s8[p - 1]) >= 0xC0) {
+    return p - 1;
+  }
+  return i;
+}
+
+}  // namespace detail
+
 //-----------------------------------------------------------------------------
 // UTF8 encoding
 //-----------------------------------------------------------------------------
@@ -150,10 +930,17 @@ inline size_t encode_codepoint(char32_t cp, std::string &out) {
   return l;
 }
 
+inline size_t exact_encoded_length(const char32_t *s32, size_t l) {
+  return detail::utf32_encoded_length(s32, l, false);
+}
+
 inline void encode(const char32_t *s32, size_t l, std::string &out) {
-  for (size_t i = 0; i < l; i++) {
-    encode_codepoint(s32[i], out);
-  }
+  detail::utf32_to_units(s32, l, out);
+}
+
+inline ConversionResult encode(const char32_t *s32, size_t l, char *out,
+                               size_t cap) {
+  return detail::utf32_to_units(s32, l, out, cap);
 }
 
 inline bool decode_codepoint(const char *s8, size_t l, size_t &bytes,
@@ -206,14 +993,63 @@ inline size_t decode_codepoint(const char *s8, size_t l, char32_t &out) {
 }
 
 inline void decode(const char *s8, size_t l, std::u32string &out) {
-  for (size_t i = 0, bytes; i < l; i += bytes) {
+  detail::utf8_to_units(s8, l, out);
+}
+
+inline ConversionResult decode(const char *s8, size_t l, std::u32string &out,
+                               ErrorPolicy policy) {
+  return detail::utf8_to_units(s8, l, out, policy);
+}
+
+// Upper bound of the code points in `l` bytes
+constexpr size_t max_decoded_length(size_t l) { return l; }
+
+inline ConversionResult decode(const char *s8, size_t l, char32_t *out,
+                               size_t cap,
+                               ErrorPolicy policy = ErrorPolicy::Skip) {
+  return detail::utf8_to_units(s8, l, out, cap, policy);
+}
+
+inline size_t validate_scalar(const char *s8, size_t l, size_t i) {
+  while (i < l) {
+    // skip ASCII 8 bytes at a time
+    if (static_cast<uint8_t>(s8[i]) < 0x80 && i + 8 <= l) {
+      uint64_t word;
+      std::memcpy(&word, s8 + i, sizeof(word));
+      if ((word & 0x8080808080808080) == 0) {
+        i += 8;
+        continue;
+      }
+    }
+    size_t bytes;
     char32_t cp;
-    if (decode_codepoint(&s8[i], l - i, bytes, cp)) {
-      out += cp;
-    } else {
-      bytes = 1;
+    if (!decode_codepoint(s8 + i, l - i, bytes, cp)) {
+      return i;
     }
+    i += bytes;
   }
+  return l;
+}
+
+// Returns the offset of the first ill-formed sequence, or `l` when the whole
+// text is well-formed.
+inline size_t validate(const char *s8, size_t l) {
+  size_t i = 0;
+#ifdef UNICODELIB_X86_64_SIMD
+  switch (detail::simd_level()) {
+    case detail::SimdLevel::AVX2:
+      i = detail::utf8_validate_avx2(s8, l);
+      break;
+    case detail::SimdLevel::SSE41:
+      i = detail::utf8_validate_sse41(s8, l);
+      break;
+    case detail::SimdLevel::None:
+      break;
+  }
+#endif
+  // The blocks stop at the first error or at the tail; find the exact offset
+  // from the start of the sequence that crosses that point.
+  return validate_scalar(s8, l, detail::utf8_sequence_start(s8, i));
 }
 
 }  // namespace utf8
@@ -307,58 +1143,880 @@ inline size_t encode_codepoint(char32_t cp, std::u16string &out) {
   return l;
 }
 
+inline size_t exact_encoded_length(const char32_t *s32, size_t l) {
+  return detail::utf32_encoded_length(s32, l, true);
+}
+
 inline void encode(const char32_t *s32, size_t l, std::u16string &out) {
-  for (size_t i = 0; i < l; i++) {
-    encode_codepoint(s32[i], out);
-  }
+  detail::utf32_to_units(s32, l, out);
+}
+
+inline ConversionResult encode(const char32_t *s32, size_t l, char16_t *out,
+                               size_t cap) {
+  return detail::utf32_to_units(s32, l, out, cap);
 }
 
 inline bool decode_codepoint(const char16_t *s16, size_t l, size_t &length,
                              char32_t &cp) {
-  if (l) {
-    // Surrogate
-    auto first = s16[0];
-    if (0xD800 <= first && first < 0xDC00) {
-      if (l >= 2) {
-        auto second = s16[1];
-        if (0xDC00 <= second && second < 0xE000) {
-          cp = (((first - 0xD800) << 10) | (second - 0xDC00)) + 0x10000;
-          length = 2;
-          return true;
+  return detail::utf16_decode_codepoint(s16, l, length, cp);
+}
+
+inline size_t decode_codepoint(const char16_t *s16, size_t l, char32_t &out) {
+  size_t length;
+  if (decode_codepoint(s16, l, length, out)) {
+    return length;
+  }
+  return 0;
+}
+
+inline void decode(const char16_t *s16, size_t l, std::u32string &out) {
+  detail::utf16_to_utf32(s16, l, out);
+}
+
+inline ConversionResult decode(const char16_t *s16, size_t l,
+                               std::u32string &out, ErrorPolicy policy) {
+  return detail::utf16_to_utf32(s16, l, out, policy);
+}
+
+// Upper bound of the code points in `l` code units
+constexpr size_t max_decoded_length(size_t l) { return l; }
+
+inline ConversionResult decode(const char16_t *s16, size_t l, char32_t *out,
+                               size_t cap,
+                               ErrorPolicy policy = ErrorPolicy::Skip) {
+  return detail::utf16_to_utf32(s16, l, out, cap, policy);
+}
+
+}  // namespace utf16
+
+//-----------------------------------------------------------------------------
+// Transcoding
+//-----------------------------------------------------------------------------
+
+namespace detail {
+
+// Length of the maximal subpart at the start of `s8`: the longest prefix of
+// a well-formed sequence, or 1 when the first byte cannot start one.
+inline size_t utf8_maximal_subpart(const char *s8, size_t l) {
+  auto b = static_cast<uint8_t>(s8[0]);
+  size_t length = 1;
+  uint8_t lo = 0x80;
+  uint8_t hi = 0xBF;
+  if (b >= 0xC2 && b <= 0xDF) {
+    length = 2;
+  } else if (b >= 0xE0 && b <= 0xEF) {
+    length = 3;
+    lo = b == 0xE0 ? 0xA0 : 0x80;  // overlong
+    hi = b == 0xED ? 0x9F : 0xBF;  // surrogates
+  } else if (b >= 0xF0 && b <= 0xF4) {
+    length = 4;
+    lo = b == 0xF0 ? 0x90 : 0x80;  // overlong
+    hi = b == 0xF4 ? 0x8F : 0xBF;  // beyond U+10FFFF
+  }
+
+  size_t i = 1;
+  while (i < length && i < l) {
+    auto c = static_cast<uint8_t>(s8[i]);
+    if (c < lo || c > hi) {
+      break;
+    }
+    lo = 0x80;
+    hi = 0xBF;
+    i++;
+  }
+  return i;
+}
+
+// Length of a sequence at the end of `s8` that is cut short but may still be
+// completed by the bytes that follow, or 0.
+inline size_t utf8_incomplete_tail(const char *s8, size_t l) {
+  auto p = utf8_sequence_start(s8, l);
+  auto length = l - p;
+  if (length == 0 || utf8_maximal_subpart(s8 + p, length) != length) {
+    return 0;
+  }
+  auto b = static_cast<uint8_t>(s8[p]);
+  size_t needed = b < 0xC2 ? 1 : b < 0xE0 ? 2 : b < 0xF0 ? 3 : b < 0xF5 ? 4 : 1;
+  return length < needed ? length : 0;
+}
+
+// Each converter writes at most `cap` units to `out` and stops at a code
+// point boundary when the next one does not fit. The SIMD kernels write at
+// most one unit per input unit, so they are given no more input than there
+// is room for.
+
+template <typename T>
+inline ConversionResult utf8_to_units(const char *s8, size_t l, T *out,
+                                      size_t cap, ErrorPolicy policy) {
+  ConversionResult result;
+  auto &i = result.read;
+  auto &written = result.written;
+  auto ill_formed = false;
+
+  while (i < l) {
+#ifdef UNICODELIB_X86_64_SIMD
+    const auto n = l - i < cap - written ? l - i : cap - written;
+    switch (simd_level()) {
+      case SimdLevel::AVX2:
+        i += utf8_decode_avx2(s8 + i, n, out, written);
+        break;
+      case SimdLevel::SSE41:
+        i += utf8_decode_sse41(s8 + i, n, out, written);
+        break;
+      case SimdLevel::None:
+        break;
+    }
+#endif
+    // Decode the block with an ill-formed sequence, or the tail, one code
+    // point at a time. Decoding resyncs after the maximal subpart, which
+    // only ever spans bytes that cannot start a sequence themselves.
+    const auto end = l - i < 32 ? l : i + 32;
+    for (size_t bytes; i < end; i += bytes) {
+      char32_t cp;
+      if (!utf8::decode_codepoint(&s8[i], l - i, bytes, cp)) {
+        ill_formed = true;
+        if (policy == ErrorPolicy::Strict) {
+          result.status = ConversionStatus::IllFormed;
+          return result;
+        }
+        bytes = utf8_maximal_subpart(&s8[i], l - i);
+        if (policy == ErrorPolicy::Skip) {
+          continue;
+        }
+        cp = 0xFFFD;
+      }
+      if constexpr (sizeof(T) == 2) {
+        char16_t buff[2];
+        auto length = utf16::encode_codepoint(cp, buff);
+        if (cap - written < length) {
+          result.status = ConversionStatus::OutputFull;
+          return result;
         }
+        for (size_t j = 0; j < length; j++) {
+          out[written++] = static_cast<T>(buff[j]);
+        }
+      } else {
+        if (cap == written) {
+          result.status = ConversionStatus::OutputFull;
+          return result;
+        }
+        out[written++] = static_cast<T>(cp);
       }
     }
+  }
+  if (ill_formed) {
+    result.status = ConversionStatus::IllFormed;
+  }
+  return result;
+}
 
-    // Non surrogate
-    else if (first < 0xD800 || first >= 0xE000) {
-      cp = first;
-      length = 1;
-      return true;
+template <typename T>
+inline ConversionResult utf8_to_units(const char *s8, size_t l,
+                                      std::basic_string<T> &out,
+                                      ErrorPolicy policy) {
+  // Every byte decodes to at most one code unit, and so does every maximal
+  // subpart replaced with U+FFFD.
+  const auto base = out.size();
+  out.resize(base + l);
+  auto result = utf8_to_units(s8, l, &out[base], l, policy);
+  out.resize(base + result.written);
+  return result;
+}
+
+template <typename T>
+inline ConversionResult utf16_to_utf8(const T *s16, size_t l, char *out,
+                                      size_t cap, ErrorPolicy policy) {
+  static_assert(sizeof(T) == 2, "UTF-16 code units expected");
+
+  ConversionResult result;
+  auto &i = result.read;
+  auto &written = result.written;
+  auto ill_formed = false;
+
+  while (i < l) {
+#ifdef UNICODELIB_X86_64_SIMD
+    // The kernels only read through vector loads.
+    auto src = reinterpret_cast<const char16_t *>(s16 + i);
+    const auto n = l - i < cap - written ? l - i : cap - written;
+    switch (simd_level()) {
+      case SimdLevel::AVX2:
+        i += utf16_to_utf8_avx2(src, n, out, written);
+        break;
+      case SimdLevel::SSE41:
+        i += utf16_to_utf8_sse41(src, n, out, written);
+        break;
+      case SimdLevel::None:
+        break;
+    }
+#endif
+    // An unpaired surrogate is a maximal subpart by itself.
+    const auto end = l - i < 32 ? l : i + 32;
+    for (size_t length; i < end; i += length) {
+      char32_t cp;
+      if (!utf16_decode_codepoint(&s16[i], l - i, length, cp)) {
+        ill_formed = true;
+        if (policy == ErrorPolicy::Strict) {
+          result.status = ConversionStatus::IllFormed;
+          return result;
+        }
+        length = 1;
+        if (policy == ErrorPolicy::Skip) {
+          continue;
+        }
+        cp = 0xFFFD;
+      }
+      if (cap - written < utf8::codepoint_length(cp)) {
+        result.status = ConversionStatus::OutputFull;
+        return result;
+      }
+      written += utf8::encode_codepoint(cp, out + written);
     }
   }
+  if (ill_formed) {
+    result.status = ConversionStatus::IllFormed;
+  }
+  return result;
+}
 
-  return false;
+template <typename T>
+inline ConversionResult utf16_to_utf8(const T *s16, size_t l,
+                                      std::string &out, ErrorPolicy policy) {
+  // A unit takes at most 3 bytes, U+FFFD included, and a surrogate pair 4.
+  const auto base = out.size();
+  out.resize(base + l * 3);
+  auto result = utf16_to_utf8(s16, l, &out[base], l * 3, policy);
+  out.resize(base + result.written);
+  return result;
 }
 
-inline size_t decode_codepoint(const char16_t *s16, size_t l, char32_t &out) {
-  size_t length;
-  if (decode_codepoint(s16, l, length, out)) {
-    return length;
+template <typename T, typename U>
+inline ConversionResult utf16_to_utf32(const T *s16, size_t l, U *out,
+                                       size_t cap, ErrorPolicy policy) {
+  static_assert(sizeof(T) == 2 && sizeof(U) == 4, "UTF-16 to UTF-32 only");
+
+  ConversionResult result;
+  auto &i = result.read;
+  auto &written = result.written;
+  auto ill_formed = false;
+
+  while (i < l) {
+#ifdef UNICODELIB_X86_64_SIMD
+    // The kernels only touch memory through vector loads and stores.
+    auto src = reinterpret_cast<const char16_t *>(s16 + i);
+    auto dst = reinterpret_cast<char32_t *>(out);
+    const auto n = l - i < cap - written ? l - i : cap - written;
+    switch (simd_level()) {
+      case SimdLevel::AVX2:
+        i += utf16_decode_avx2(src, n, dst, written);
+        break;
+      case SimdLevel::SSE41:
+        i += utf16_decode_sse41(src, n, dst, written);
+        break;
+      case SimdLevel::None:
+        break;
+    }
+#endif
+    // An unpaired surrogate is a maximal subpart by itself.
+    const auto end = l - i < 32 ? l : i + 32;
+    for (size_t length; i < end; i += length) {
+      char32_t cp;
+      if (!utf16_decode_codepoint(&s16[i], l - i, length, cp)) {
+        ill_formed = true;
+        if (policy == ErrorPolicy::Strict) {
+          result.status = ConversionStatus::IllFormed;
+          return result;
+        }
+        length = 1;
+        if (policy == ErrorPolicy::Skip) {
+          continue;
+        }
+        cp = 0xFFFD;
+      }
+      if (cap == written) {
+        result.status = ConversionStatus::OutputFull;
+        return result;
+      }
+      out[written++] = static_cast<U>(cp);
+    }
   }
-  return 0;
+  if (ill_formed) {
+    result.status = ConversionStatus::IllFormed;
+  }
+  return result;
 }
 
-inline void decode(const char16_t *s16, size_t l, std::u32string &out) {
-  for (size_t i = 0, length; i < l; i += length) {
-    char32_t cp;
-    if (decode_codepoint(&s16[i], l - i, length, cp)) {
-      out += cp;
+template <typename T, typename U>
+inline ConversionResult utf16_to_utf32(const T *s16, size_t l,
+                                       std::basic_string<U> &out,
+                                       ErrorPolicy policy) {
+  // Every unit decodes to at most one code point.
+  const auto base = out.size();
+  out.resize(base + l);
+  auto result = utf16_to_utf32(s16, l, &out[base], l, policy);
+  out.resize(base + result.written);
+  return result;
+}
+
+template <typename T>
+inline size_t utf32_encoded_length(const T *s32, size_t l, bool to_utf16) {
+  static_assert(sizeof(T) == 4, "UTF-32 code units expected");
+
+  size_t length = 0;
+  size_t i = 0;
+#ifdef UNICODELIB_X86_64_SIMD
+  auto src = reinterpret_cast<const char32_t *>(s32);
+  switch (simd_level()) {
+    case SimdLevel::AVX2:
+      length = utf32_encoded_length_avx2(src, l, to_utf16);
+      i = l / 8 * 8;
+      break;
+    case SimdLevel::SSE41:
+      length = utf32_encoded_length_sse41(src, l, to_utf16);
+      i = l / 8 * 8;
+      break;
+    case SimdLevel::None:
+      break;
+  }
+#endif
+  for (; i < l; i++) {
+    auto cp = static_cast<char32_t>(s32[i]);
+    length +=
+        to_utf16 ? utf16::codepoint_length(cp) : utf8::codepoint_length(cp);
+  }
+  return length;
+}
+
+template <typename T, typename U>
+inline ConversionResult utf32_to_units(const T *s32, size_t l, U *out,
+                                       size_t cap) {
+  static_assert(sizeof(T) == 4 && sizeof(U) <= 2, "UTF-32 to UTF-8/16 only");
+
+  ConversionResult result;
+  auto &i = result.read;
+  auto &written = result.written;
+  auto dropped = false;
+
+  while (i < l) {
+#ifdef UNICODELIB_X86_64_SIMD
+    auto src = reinterpret_cast<const char32_t *>(s32 + i);
+    const auto n = l - i < cap - written ? l - i : cap - written;
+    if constexpr (sizeof(U) == 1) {
+      switch (simd_level()) {
+        case SimdLevel::AVX2:
+          i += utf8_encode_avx2(src, n, out, written);
+          break;
+        case SimdLevel::SSE41:
+          i += utf8_encode_sse41(src, n, out, written);
+          break;
+        case SimdLevel::None:
+          break;
+      }
     } else {
-      length = 1;
+      auto dst = reinterpret_cast<char16_t *>(out);
+      switch (simd_level()) {
+        case SimdLevel::AVX2:
+          i += utf16_encode_avx2(src, n, dst, written);
+          break;
+        case SimdLevel::SSE41:
+          i += utf16_encode_sse41(src, n, dst, written);
+          break;
+        case SimdLevel::None:
+          break;
+      }
+    }
+#endif
+    // Surrogates and values beyond U+10FFFF are dropped.
+    const auto end = l - i < 32 ? l : i + 32;
+    for (; i < end; i++) {
+      auto cp = static_cast<char32_t>(s32[i]);
+      if constexpr (sizeof(U) == 1) {
+        auto length = utf8::codepoint_length(cp);
+        if (cap - written < length) {
+          result.status = ConversionStatus::OutputFull;
+          return result;
+        }
+        written += utf8::encode_codepoint(cp, out + written);
+        dropped |= length == 0;
+      } else {
+        char16_t buff[2];
+        auto length = utf16::encode_codepoint(cp, buff);
+        if (cap - written < length) {
+          result.status = ConversionStatus::OutputFull;
+          return result;
+        }
+        for (size_t j = 0; j < length; j++) {
+          out[written++] = static_cast<U>(buff[j]);
+        }
+        dropped |= length == 0;
+      }
     }
   }
+  result.status = dropped ? ConversionStatus::IllFormed : ConversionStatus::Ok;
+  return result;
 }
 
+template <typename T, typename U>
+inline void utf32_to_units(const T *s32, size_t l, std::basic_string<U> &out) {
+  // Size the output once, then fill it in.
+  const auto base = out.size();
+  const auto length = utf32_encoded_length(s32, l, sizeof(U) == 2);
+  out.resize(base + length);
+  utf32_to_units(s32, l, &out[base], length);
+}
+
+}  // namespace detail
+
+//-----------------------------------------------------------------------------
+// Streaming decoders
+//-----------------------------------------------------------------------------
+
+namespace utf8 {
+
+// Decodes UTF-8 that arrives in chunks. A sequence cut off at the end of a
+// chunk is held back and completed by the next one, so the result does not
+// depend on where the chunks are split.
+class StreamDecoder {
+public:
+  explicit StreamDecoder(ErrorPolicy policy = ErrorPolicy::Skip)
+      : policy_(policy) {}
+
+  // Appends the code points completed by `s8` to `out`. Under
+  // ErrorPolicy::Strict, decoding stops at the first ill-formed sequence and
+  // the rest of the stream is ignored until finish().
+  ConversionStatus feed(const char *s8, size_t l, std::u32string &out) {
+    if (failed_) {
+      return ConversionStatus::IllFormed;
+    }
+
+    auto ill_formed = false;
+    size_t i = 0;
+
+    if (pending_length_) {
+      // Finish the held-back sequence with the first bytes of this chunk.
+      char buff[4];
+      size_t n = 0;
+      for (; n < pending_length_; n++) {
+        buff[n] = pending_[n];
+      }
+      for (; n < 4 && i < l; n++) {
+        buff[n] = s8[i++];
+      }
+
+      if (detail::utf8_incomplete_tail(buff, n) == n) {
+        pending_length_ = n;
+        for (size_t j = 0; j < n; j++) {
+          pending_[j] = buff[j];
+        }
+        return ConversionStatus::Ok;
+      }
+
+      size_t bytes;
+      char32_t cp;
+      if (!decode_codepoint(buff, n, bytes, cp)) {
+        if (policy_ == ErrorPolicy::Strict) {
+          return fail();
+        }
+        bytes = detail::utf8_maximal_subpart(buff, n);
+        ill_formed = true;
+        cp = 0xFFFD;
+      }
+      if (!ill_formed || policy_ == ErrorPolicy::Replace) {
+        out += cp;
+      }
+      // The held-back bytes are a valid prefix, so they are all used up.
+      i = bytes - pending_length_;
+      consumed_ += bytes;
+      pending_length_ = 0;
+    }
+
+    auto tail = detail::utf8_incomplete_tail(s8 + i, l - i);
+    auto result = detail::utf8_to_units(s8 + i, l - i - tail, out, policy_);
+    consumed_ += result.read;
+    if (result.read < l - i - tail) {
+      return fail();
+    }
+    for (size_t j = 0; j < tail; j++) {
+      pending_[j] = s8[l - tail + j];
+    }
+    pending_length_ = tail;
+
+    if (ill_formed || result.status == ConversionStatus::IllFormed) {
+      return ConversionStatus::IllFormed;
+    }
+    return ConversionStatus::Ok;
+  }
+
+  ConversionStatus feed(std::string_view s8, std::u32string &out) {
+    return feed(s8.data(), s8.length(), out);
+  }
+
+  // Ends the stream. A sequence still held back is ill-formed. The decoder
+  // can then be used for a new stream.
+  ConversionStatus finish(std::u32string &out) {
+    auto status = ConversionStatus::Ok;
+    if (failed_ || pending_length_) {
+      if (!failed_ && policy_ == ErrorPolicy::Replace) {
+        out += U'\uFFFD';
+      }
+      status = ConversionStatus::IllFormed;
+    }
+    pending_length_ = 0;
+    consumed_ = 0;
+    failed_ = false;
+    return status;
+  }
+
+  // Bytes held back until the next chunk
+  size_t pending() const { return pending_length_; }
+
+  // Bytes of the stream decoded so far. Once feed() has failed under
+  // ErrorPolicy::Strict, the offset of the ill-formed sequence.
+  size_t consumed() const { return consumed_; }
+
+private:
+  ConversionStatus fail() {
+    pending_length_ = 0;
+    failed_ = true;
+    return ConversionStatus::IllFormed;
+  }
+
+  ErrorPolicy policy_;
+  char pending_[3] = {};
+  size_t pending_length_ = 0;
+  size_t consumed_ = 0;
+  bool failed_ = false;
+};
+
+}  // namespace utf8
+
+namespace utf16 {
+
+// Decodes UTF-16 that arrives in chunks. A high surrogate at the end of a
+// chunk is held back and paired with the next one.
+class StreamDecoder {
+public:
+  explicit StreamDecoder(ErrorPolicy policy = ErrorPolicy::Skip)
+      : policy_(policy) {}
+
+  // Appends the code points completed by `s16` to `out`. Under
+  // ErrorPolicy::Strict, decoding stops at the first unpaired surrogate and
+  // the rest of the stream is ignored until finish().
+  ConversionStatus feed(const char16_t *s16, size_t l, std::u32string &out) {
+    if (failed_) {
+      return ConversionStatus::IllFormed;
+    }
+    if (!l) {
+      return ConversionStatus::Ok;
+    }
+
+    auto ill_formed = false;
+    size_t i = 0;
+
+    if (has_pending_) {
+      // Pair the held-back high surrogate with the first unit of this chunk.
+      char16_t buff[2] = {pending_, s16[0]};
+      size_t length;
+      char32_t cp;
+      if (decode_codepoint(buff, 2, length, cp)) {
+        out += cp;
+        i = 1;
+        consumed_ += 2;
+      } else if (policy_ == ErrorPolicy::Strict) {
+        return fail();
+      } else {
+        ill_formed = true;
+        if (policy_ == ErrorPolicy::Replace) {
+          out += U'\uFFFD';
+        }
+        consumed_ += 1;
+      }
+      has_pending_ = false;
+    }
+
+    size_t tail = 0;
+    if (i < l && s16[l - 1] >= 0xD800 && s16[l - 1] < 0xDC00) {
+      tail = 1;
+    }
+    auto result = detail::utf16_to_utf32(s16 + i, l - i - tail, out, policy_);
+    consumed_ += result.read;
+    if (result.read < l - i - tail) {
+      return fail();
+    }
+    if (tail) {
+      pending_ = s16[l - 1];
+      has_pending_ = true;
+    }
+
+    if (ill_formed || result.status == ConversionStatus::IllFormed) {
+      return ConversionStatus::IllFormed;
+    }
+    return ConversionStatus::Ok;
+  }
+
+  ConversionStatus feed(std::u16string_view s16, std::u32string &out) {
+    return feed(s16.data(), s16.length(), out);
+  }
+
+  // Ends the stream. A high surrogate still held back is unpaired. The
+  // decoder can then be used for a new stream.
+  ConversionStatus finish(std::u32string &out) {
+    auto status = ConversionStatus::Ok;
+    if (failed_ || has_pending_) {
+      if (!failed_ && policy_ == ErrorPolicy::Replace) {
+        out += U'\uFFFD';
+      }
+      status = ConversionStatus::IllFormed;
+    }
+    has_pending_ = false;
+    consumed_ = 0;
+    failed_ = false;
+    return status;
+  }
+
+  // Code units held back until the next chunk
+  size_t pending() const { return has_pending_ ? 1 : 0; }
+
+  // Code units of the stream decoded so far. Once feed() has failed under
+  // ErrorPolicy::Strict, the offset of the unpaired surrogate.
+  size_t consumed() const { return consumed_; }
+
+private:
+  ConversionStatus fail() {
+    has_pending_ = false;
+    failed_ = true;
+    return ConversionStatus::IllFormed;
+  }
+
+  ErrorPolicy policy_;
+  char16_t pending_ = 0;
+  bool has_pending_ = false;
+  size_t consumed_ = 0;
+  bool failed_ = false;
+};
+
+}  // namespace utf16
+
+//-----------------------------------------------------------------------------
+// Code point views
+//-----------------------------------------------------------------------------
+
+namespace utf8 {
+
+// A bidirectional range over the code points of UTF-8 text that decodes them
+// as it goes, without allocating. Each maximal subpart of ill-formed input
+// comes out as one U+FFFD, as with ErrorPolicy::Replace, so every byte of the
+// text belongs to exactly one position.
+class codepoint_view {
+public:
+  class iterator {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = char32_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const char32_t *;
+    using reference = char32_t;
+
+    iterator() = default;
+
+    char32_t operator*() const { return cp_; }
+
+    // Where the code point starts in the text, and how many bytes it takes
+    size_t offset() const { return i_; }
+    size_t length() const { return length_; }
+
+    iterator &operator++() {
+      i_ += length_;
+      decode();
+      return *this;
+    }
+
+    iterator operator++(int) {
+      auto it = *this;
+      ++*this;
+      return it;
+    }
+
+    iterator &operator--() {
+      // Back up to the lead byte of the sequence that ends here. When there
+      // is none, the byte before is a stray continuation byte.
+      const auto end = i_;
+      i_--;
+      while (i_ > 0 && end - i_ < 4 &&
+             (static_cast<uint8_t>(s8_[i_]) & 0xC0) == 0x80) {
+        i_--;
+      }
+      decode();
+      if (i_ + length_ != end) {
+        i_ = end - 1;
+        decode();
+      }
+      return *this;
+    }
+
+    iterator operator--(int) {
+      auto it = *this;
+      --*this;
+      return it;
+    }
+
+    friend bool operator==(const iterator &a, const iterator &b) {
+      return a.i_ == b.i_;
+    }
+
+    friend bool operator!=(const iterator &a, const iterator &b) {
+      return a.i_ != b.i_;
+    }
+
+  private:
+    friend class codepoint_view;
+
+    iterator(const char *s8, size_t l, size_t i) : s8_(s8), l_(l), i_(i) {
+      decode();
+    }
+
+    void decode() {
+      if (i_ == l_) {
+        length_ = 0;
+        cp_ = 0;
+      } else if (!decode_codepoint(s8_ + i_, l_ - i_, length_, cp_)) {
+        length_ = detail::utf8_maximal_subpart(s8_ + i_, l_ - i_);
+        cp_ = 0xFFFD;
+      }
+    }
+
+    const char *s8_ = nullptr;
+    size_t l_ = 0;
+    size_t i_ = 0;
+    size_t length_ = 0;
+    char32_t cp_ = 0;
+  };
+
+  using const_iterator = iterator;
+
+  codepoint_view() = default;
+  codepoint_view(const char *s8, size_t l) : s8_(s8), l_(l) {}
+  codepoint_view(std::string_view s8) : s8_(s8.data()), l_(s8.length()) {}
+
+  iterator begin() const { return iterator(s8_, l_, 0); }
+  iterator end() const { return iterator(s8_, l_, l_); }
+
+  // The position at byte offset `i`, which should start a code point
+  iterator at(size_t i) const { return iterator(s8_, l_, i); }
+
+  bool empty() const { return l_ == 0; }
+
+private:
+  const char *s8_ = nullptr;
+  size_t l_ = 0;
+};
+
+}  // namespace utf8
+
+namespace utf16 {
+
+// A bidirectional range over the code points of UTF-16 text that decodes
+// them as it goes, without allocating. An unpaired surrogate comes out as
+// U+FFFD.
+class codepoint_view {
+public:
+  class iterator {
+  public:
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = char32_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const char32_t *;
+    using reference = char32_t;
+
+    iterator() = default;
+
+    char32_t operator*() const { return cp_; }
+
+    // Where the code point starts in the text, and how many code units it
+    // takes
+    size_t offset() const { return i_; }
+    size_t length() const { return length_; }
+
+    iterator &operator++() {
+      i_ += length_;
+      decode();
+      return *this;
+    }
+
+    iterator operator++(int) {
+      auto it = *this;
+      ++*this;
+      return it;
+    }
+
+    iterator &operator--() {
+      if (i_ >= 2 && is_surrogate_pair(s16_ + i_ - 2, 2)) {
+        i_ -= 2;
+      } else {
+        i_--;
+      }
+      decode();
+      return *this;
+    }
+
+    iterator operator--(int) {
+      auto it = *this;
+      --*this;
+      return it;
+    }
+
+    friend bool operator==(const iterator &a, const iterator &b) {
+      return a.i_ == b.i_;
+    }
+
+    friend bool operator!=(const iterator &a, const iterator &b) {
+      return a.i_ != b.i_;
+    }
+
+  private:
+    friend class codepoint_view;
+
+    iterator(const char16_t *s16, size_t l, size_t i)
+        : s16_(s16), l_(l), i_(i) {
+      decode();
+    }
+
+    void decode() {
+      if (i_ == l_) {
+        length_ = 0;
+        cp_ = 0;
+      } else if (!decode_codepoint(s16_ + i_, l_ - i_, length_, cp_)) {
+        length_ = 1;
+        cp_ = 0xFFFD;
+      }
+    }
+
+    const char16_t *s16_ = nullptr;
+    size_t l_ = 0;
+    size_t i_ = 0;
+    size_t length_ = 0;
+    char32_t cp_ = 0;
+  };
+
+  using const_iterator = iterator;
+
+  codepoint_view() = default;
+  codepoint_view(const char16_t *s16, size_t l) : s16_(s16), l_(l) {}
+  codepoint_view(std::u16string_view s16)
+      : s16_(s16.data()), l_(s16.length()) {}
+
+  iterator begin() const { return iterator(s16_, l_, 0); }
+  iterator end() const { return iterator(s16_, l_, l_); }
+
+  // The position at code unit offset `i`, which should start a code point
+  iterator at(size_t i) const { return iterator(s16_, l_, i); }
+
+  bool empty() const { return l_ == 0; }
+
+private:
+  const char16_t *s16_ = nullptr;
+  size_t l_ = 0;
+};
+
 }  // namespace utf16
 
 //-----------------------------------------------------------------------------
@@ -423,6 +2081,21 @@ inline std::u32string decode(std::string_view s8) {
   return decode(s8.data(), s8.length());
 }
 
+inline ConversionResult decode(std::string_view s8, std::u32string &out,
+                               ErrorPolicy policy) {
+  return decode(s8.data(), s8.length(), out, policy);
+}
+
+inline std::u32string decode(std::string_view s8, ErrorPolicy policy) {
+  std::u32string out;
+  decode(s8.data(), s8.length(), out, policy);
+  return out;
+}
+
+inline size_t validate(std::string_view s8) {
+  return validate(s8.data(), s8.length());
+}
+
 }  // namespace utf8
 
 namespace utf16 {
@@ -483,6 +2156,17 @@ inline std::u32string decode(std::u16string_view s16) {
   return decode(s16.data(), s16.length());
 }
 
+inline ConversionResult decode(std::u16string_view s16, std::u32string &out,
+                               ErrorPolicy policy) {
+  return decode(s16.data(), s16.length(), out, policy);
+}
+
+inline std::u32string decode(std::u16string_view s16, ErrorPolicy policy) {
+  std::u32string out;
+  decode(s16.data(), s16.length(), out, policy);
+  return out;
+}
+
 }  // namespace utf16
 
 //-----------------------------------------------------------------------------
@@ -490,21 +2174,39 @@ inline std::u32string decode(std::u16string_view s16) {
 //-----------------------------------------------------------------------------
 
 inline std::string to_utf8(const char16_t *s16, size_t l) {
-  return utf8::encode(utf16::decode(s16, l));
+  std::string out;
+  detail::utf16_to_utf8(s16, l, out);
+  return out;
 }
 
 inline std::string to_utf8(std::u16string_view s16) {
   return to_utf8(s16.data(), s16.length());
 }
 
+// `out` needs at most 3 bytes per UTF-16 code unit.
+inline ConversionResult to_utf8(const char16_t *s16, size_t l, char *out,
+                                size_t cap,
+                                ErrorPolicy policy = ErrorPolicy::Skip) {
+  return detail::utf16_to_utf8(s16, l, out, cap, policy);
+}
+
 inline std::u16string to_utf16(const char *s8, size_t l) {
-  return utf16::encode(utf8::decode(s8, l));
+  std::u16string out;
+  detail::utf8_to_units(s8, l, out);
+  return out;
 }
 
 inline std::u16string to_utf16(std::string_view s8) {
   return to_utf16(s8.data(), s8.length());
 }
 
+// `out` needs at most one UTF-16 code unit per byte.
+inline ConversionResult to_utf16(const char *s8, size_t l, char16_t *out,
+                                 size_t cap,
+                                 ErrorPolicy policy = ErrorPolicy::Skip) {
+  return detail::utf8_to_units(s8, l, out, cap, policy);
+}
+
 //-----------------------------------------------------------------------------
 // std::wstring conversion
 //-----------------------------------------------------------------------------
@@ -512,56 +2214,56 @@ inline std::u16string to_utf16(std::string_view s8) {
 namespace detail {
 
 inline std::wstring to_wstring_core(const char *s8, size_t l) {
-  if constexpr (sizeof(wchar_t) == 2) {
-    auto s16 = utf16::encode(utf8::decode(s8, l));
-    return std::wstring(s16.begin(), s16.end());
-  } else if constexpr (sizeof(wchar_t) == 4) {
-    auto s32 = utf8::decode(s8, l);
-    return std::wstring(s32.begin(), s32.end());
-  }
+  std::wstring out;
+  utf8_to_units(s8, l, out);
+  return out;
 }
 
 inline std::wstring to_wstring_core(const char16_t *s16, size_t l) {
   if constexpr (sizeof(wchar_t) == 2) {
     return std::wstring(s16, s16 + l);
   } else if constexpr (sizeof(wchar_t) == 4) {
-    auto s32 = utf16::decode(s16, l);
-    return std::wstring(s32.begin(), s32.end());
+    std::wstring out;
+    utf16_to_utf32(s16, l, out);
+    return out;
   }
 }
 
 inline std::wstring to_wstring_core(const char32_t *s32, size_t l) {
   if constexpr (sizeof(wchar_t) == 2) {
-    auto s16 = utf16::encode(s32, l);
-    return std::wstring(s16.begin(), s16.end());
+    std::wstring out;
+    utf32_to_units(s32, l, out);
+    return out;
   } else if constexpr (sizeof(wchar_t) == 4) {
     return std::wstring(s32, s32 + l);
   }
 }
 
 inline std::string to_utf8_core(const wchar_t *sw, size_t l) {
+  std::string out;
   if constexpr (sizeof(wchar_t) == 2) {
-    std::u16string buf(sw, sw + l);
-    return utf8::encode(utf16::decode(buf.data(), l));
+    utf16_to_utf8(sw, l, out);
   } else if constexpr (sizeof(wchar_t) == 4) {
-    std::u32string buf(sw, sw + l);
-    return utf8::encode(buf.data(), l);
+    utf32_to_units(sw, l, out);
   }
+  return out;
 }
 
 inline std::u16string to_utf16_core(const wchar_t *sw, size_t l) {
   if constexpr (sizeof(wchar_t) == 2) {
     return std::u16string(sw, sw + l);
   } else if constexpr (sizeof(wchar_t) == 4) {
-    std::u32string buf(sw, sw + l);
-    return utf16::encode(buf.data(), l);
+    std::u16string out;
+    utf32_to_units(sw, l, out);
+    return out;
   }
 }
 
 inline std::u32string to_utf32_core(const wchar_t *sw, size_t l) {
   if constexpr (sizeof(wchar_t) == 2) {
-    std::u16string buf(sw, sw + l);
-    return utf16::decode(buf.data(), l);
+    std::u32string out;
+    utf16_to_utf32(sw, l, out);
+    return out;
   } else if constexpr (sizeof(wchar_t) == 4) {
     return std::u32string(sw, sw + l);
   }